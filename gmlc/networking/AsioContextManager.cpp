@@ -18,6 +18,7 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include "AsioContextManager.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <map>
@@ -29,6 +30,11 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 #include <utility>
 #include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace gmlc::networking {
 /** a storage system for the available core objects allowing references by name
  * to the core
@@ -122,6 +128,13 @@ void AsioContextManager::closeContext(const std::string& contextName)
     }
 }
 
+void AsioContextManager::setContextThreadCount(
+    int count,
+    const std::string& contextName)
+{
+    getContextPointer(contextName)->setThreadCount(count);
+}
+
 void AsioContextManager::setContextToLeakOnDelete(
     const std::string& contextName)
 {
@@ -231,6 +244,70 @@ AsioContextManager::LoopHandle AsioContextManager::startContextLoop()
     return std::make_unique<Servicer>(std::move(ptr));
 }
 
+void AsioContextManager::setThreadCount(int count)
+{
+    if (count <= 0) {
+        count = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threadCount.store((count > 0) ? count : 1);
+}
+
+void AsioContextManager::setThreadName(const std::string& newName)
+{
+    std::lock_guard<std::mutex> nameLock(threadNameLock);
+    threadName = newName;
+}
+
+void AsioContextManager::configureThread(int index)
+{
+    std::string nameBase;
+    {
+        std::lock_guard<std::mutex> nameLock(threadNameLock);
+        nameBase = threadName;
+    }
+#ifdef __linux__
+    if (!nameBase.empty()) {
+        // linux limits thread names to 15 characters
+        auto fullName = nameBase;
+        if (index > 0) {
+            fullName = nameBase.substr(0, 12) + '.' + std::to_string(index);
+        }
+        fullName.resize((std::min)(fullName.size(), size_t{15}));
+        pthread_setname_np(pthread_self(), fullName.c_str());
+    }
+    const int cpu = cpuAffinity.load();
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        auto result =
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (result != 0) {
+            std::cerr << "unable to set the cpu affinity of context " << name
+                      << " to cpu " << cpu << std::endl;
+        }
+    }
+#else
+    (void)index;
+#endif
+}
+
+std::shared_ptr<LatencyHistograms> AsioContextManager::enableLatencyHistograms()
+{
+    std::lock_guard<std::mutex> histLock(histogramLock);
+    if (!histograms) {
+        histograms = std::make_shared<LatencyHistograms>();
+    }
+    return histograms;
+}
+
+std::shared_ptr<LatencyHistograms>
+    AsioContextManager::getLatencyHistograms() const
+{
+    std::lock_guard<std::mutex> histLock(histogramLock);
+    return histograms;
+}
+
 void AsioContextManager::haltContextLoop()
 {
     if (isRunning()) {
@@ -267,16 +344,12 @@ void AsioContextManager::haltContextLoop()
     }
 }
 
-void contextProcessingLoop(std::shared_ptr<AsioContextManager> ptr)
+void AsioContextManager::runContext()
 {
-    if (!ptr) {
-        return;
-    }
-    while ((ptr->runCounter > 0) && (!(ptr->terminateLoop))) {
+    while ((runCounter > 0) && (!terminateLoop)) {
         auto clk = std::chrono::steady_clock::now();
         try {
-            ptr->running.store(AsioContextManager::loop_mode::running);
-            ptr->ictx->run();
+            ictx->run();
         }
         catch (const std::system_error& se) {
             auto nclk = std::chrono::steady_clock::now();
@@ -294,6 +367,39 @@ void contextProcessingLoop(std::shared_ptr<AsioContextManager> ptr)
             std::cout << "caught other error in context loop" << std::endl;
         }
     }
+}
+
+void contextProcessingLoop(std::shared_ptr<AsioContextManager> ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    // this thread owns the helpers so the loop future is only ready once
+    // every thread has stopped running the context
+    std::vector<std::thread> helpers;
+    const int count = ptr->threadCount.load();
+    try {
+        helpers.reserve(count - 1);
+        for (int ii = 1; ii < count; ++ii) {
+            helpers.emplace_back([ptr, ii]() {
+                ptr->configureThread(ii);
+                ptr->runContext();
+            });
+        }
+    }
+    catch (const std::exception& e) {
+        // the helpers already started are joined below, the context keeps
+        // running on fewer threads
+        std::cerr << "unable to start all threads for context " << ptr->name
+                  << ", running " << helpers.size() + 1 << " of " << count
+                  << ": " << e.what() << std::endl;
+    }
+    ptr->configureThread(0);
+    ptr->running.store(AsioContextManager::loop_mode::running);
+    ptr->runContext();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
 
     //   std::cout << "context loop stopped\n";
     ptr->running.store(AsioContextManager::loop_mode::stopped);
@@ -19,6 +19,8 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #pragma once
 
+#include "LatencyHistogram.hpp"
+
 #include <asio/io_context.hpp>
 #include <atomic>
 #include <future>
@@ -43,6 +45,14 @@ class AsioContextManager
     static std::vector<std::shared_future<void>> futures;
     std::atomic<int> runCounter{0};  //!< counter for the number of times the
                                      //!< runContextLoop has been called
+    /// the number of threads running the context when the loop is started
+    std::atomic<int> threadCount{1};
+    /// the cpu the threads are pinned to, -1 for no affinity
+    std::atomic<int> cpuAffinity{-1};
+    /// protects threadName, runningLoopLock is held while the loop stops
+    mutable std::mutex threadNameLock;
+    /// the name given to the threads
+    std::string threadName;
     std::string name;  //!< context name
     std::unique_ptr<asio::io_context> ictx;  //!< pointer to the actual context
     std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>>
@@ -60,6 +70,10 @@ class AsioContextManager
     std::atomic<bool> terminateLoop{false};
     /// storage location for the processing loop completion
     std::shared_future<void> loopRet;
+    /// protects the histograms pointer
+    mutable std::mutex histogramLock;
+    /// latency histograms shared by connections using the context
+    std::shared_ptr<LatencyHistograms> histograms;
     /** constructor*/
     explicit AsioContextManager(const std::string& contextName);
 
@@ -118,6 +132,14 @@ class AsioContextManager
         getExistingContext(const std::string& contextName = std::string());
 
     static void closeContext(const std::string& contextName = std::string());
+    /** set the number of threads used to run a context
+    @details creates the context if it does not exist
+    @param count the number of threads, 0 for one per hardware thread
+    @param contextName the name of the context
+    */
+    static void setContextThreadCount(
+        int count,
+        const std::string& contextName = std::string());
     /** tell the context to free the pointer and leak the memory on delete
     @details You may ask why, well in windows systems when operating in a DLL if
     this context is closed after certain other operations that happen when the
@@ -146,13 +168,48 @@ class AsioContextManager
     static LoopHandle
         runContextLoop(const std::string& contextName = std::string{});
 
-    /** run a single thread for the context manager to execute asynchronous
+    /** run the threads for the context manager to execute asynchronous
     contexts in
-    @details will run a single thread for the io_context,  it will not stop the
-    thread until either the context manager is closed or the haltContextLoop
-    function is called and there is no more work
+    @details will run the number of threads set with setThreadCount (one by
+    default) for the io_context, it will not stop the threads until either the
+    context manager is closed or the haltContextLoop function is called and
+    there is no more work
     */
     LoopHandle startContextLoop();
+    /** get the latency histograms for the context, creating them if needed
+    @details connections record into them once given the pointer through
+    TcpConnection::setLatencyHistograms or TcpServer::setLatencyHistograms
+    */
+    std::shared_ptr<LatencyHistograms> enableLatencyHistograms();
+    /** get the latency histograms for the context
+    @return the histograms or nullptr if they were never enabled*/
+    std::shared_ptr<LatencyHistograms> getLatencyHistograms() const;
+    /** set the number of threads that run the context
+    @details sockets, connectors and acceptors each run their completion
+    handlers on their own strand so the handlers for a single connection never
+    run concurrently, but handlers for different connections and acceptors
+    may.  Handlers posted directly to the context have no such guarantee.  The
+    change takes effect the next time the context loop starts, if some of the
+    threads can't be created the context runs on those that could.
+    @param count the number of threads, 0 for one per hardware thread
+    */
+    void setThreadCount(int count);
+    /** get the number of threads that run the context once started*/
+    int getThreadCount() const { return threadCount.load(); }
+    /** pin the threads running the context to a single cpu
+    @details only supported on linux, elsewhere it has no effect.  The change
+    takes effect the next time the context loop starts.
+    @param cpu the index of the cpu, -1 to let the threads run anywhere
+    */
+    void setCpuAffinity(int cpu) { cpuAffinity.store(cpu); }
+    /** get the cpu the threads running the context are pinned to, -1 if none*/
+    int getCpuAffinity() const { return cpuAffinity.load(); }
+    /** set the name of the threads running the context as seen by debuggers
+    and profilers
+    @details only supported on linux where the name is limited to 15
+    characters, the change takes effect the next time the context loop
+    starts*/
+    void setThreadName(const std::string& newName);
     /** check if the contextLoopo is running*/
     bool isRunning() const { return (running.load() != loop_mode::stopped); }
 
@@ -163,6 +220,12 @@ class AsioContextManager
     */
     void haltContextLoop();
 
+    /** apply the name and cpu affinity to the calling thread
+    @param index the index of the thread among those running the context*/
+    void configureThread(int index);
+    /** run the io_context on the calling thread until the loop terminates*/
+    void runContext();
+
     friend void contextProcessingLoop(std::shared_ptr<AsioContextManager> ptr);
     /** just store the future state for reference*/
     static void storeFuture(std::shared_future<void> processReturn);
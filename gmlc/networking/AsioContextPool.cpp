@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "AsioContextPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace gmlc::networking {
+
+namespace {
+    /** get the cpus the process is allowed to run on*/
+    std::vector<int> allowedCpus()
+    {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &cpuSet)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            const auto cpuCount = (std::max)(
+                static_cast<int>(std::thread::hardware_concurrency()), 1);
+            for (int cpu = 0; cpu < cpuCount; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+}  // namespace
+
+std::shared_ptr<AsioContextPool> AsioContextPool::create(
+    const std::string& poolName,
+    int contextCount,
+    bool pinThreads)
+{
+    const auto cpus = allowedCpus();
+    if (contextCount <= 0) {
+        contextCount = static_cast<int>(cpus.size());
+    }
+    auto pool =
+        std::shared_ptr<AsioContextPool>(new AsioContextPool(poolName));
+    pool->managers.reserve(contextCount);
+    for (int ii = 0; ii < contextCount; ++ii) {
+        auto manager = AsioContextManager::getContextPointer(
+            poolName + '#' + std::to_string(ii));
+        manager->setThreadCount(1);
+        manager->setThreadName(poolName + std::to_string(ii));
+        manager->setCpuAffinity(
+            pinThreads ? cpus[ii % cpus.size()] : -1);
+        pool->managers.push_back(std::move(manager));
+    }
+    return pool;
+}
+
+AsioContextPool::~AsioContextPool()
+{
+    try {
+        stop();
+        for (const auto& manager : managers) {
+            AsioContextManager::closeContext(manager->getName());
+        }
+    }
+    catch (...) {
+        // no exceptions in a destructor
+    }
+}
+
+asio::io_context& AsioContextPool::nextContext()
+{
+    auto index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    return managers[index % managers.size()]->getBaseContext();
+}
+
+asio::io_context& AsioContextPool::getContext(std::size_t key)
+{
+    return managers[key % managers.size()]->getBaseContext();
+}
+
+asio::io_context& AsioContextPool::getContext(const std::string& key)
+{
+    return getContext(std::hash<std::string>{}(key));
+}
+
+std::shared_ptr<AsioContextManager>
+    AsioContextPool::getContextManager(std::size_t index) const
+{
+    return managers.at(index);
+}
+
+void AsioContextPool::start()
+{
+    std::lock_guard<std::mutex> lock(loopLock);
+    if (!loops.empty()) {
+        return;
+    }
+    loops.reserve(managers.size());
+    for (const auto& manager : managers) {
+        loops.push_back(manager->startContextLoop());
+    }
+}
+
+void AsioContextPool::stop()
+{
+    std::vector<AsioContextManager::LoopHandle> stopping;
+    {
+        std::lock_guard<std::mutex> lock(loopLock);
+        stopping.swap(loops);
+    }
+    // releasing the handles halts the loops
+    stopping.clear();
+}
+
+bool AsioContextPool::isRunning() const
+{
+    std::lock_guard<std::mutex> lock(loopLock);
+    return !loops.empty();
+}
+
+}  // namespace gmlc::networking
@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "AsioContextManager.h"
+
+#include <asio/io_context.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gmlc::networking {
+/** a group of io_contexts each run by a single thread
+@details handlers on different contexts never contend with each other, so
+spreading connections over one context per core avoids the locking inside a
+single context run by many threads.  The contexts are regular named context
+managers called poolName#index.
+*/
+class AsioContextPool {
+  public:
+    /** create a pool of contexts
+    @param poolName the base name of the contexts
+    @param contextCount the number of contexts, 0 for one per cpu the process
+    is allowed to run on
+    @param pinThreads set to true to pin the thread of each context to its own
+    cpu from the set the process is allowed to run on
+    */
+    static std::shared_ptr<AsioContextPool> create(
+        const std::string& poolName,
+        int contextCount = 0,
+        bool pinThreads = true);
+    /** stops the context loops and removes the contexts*/
+    ~AsioContextPool();
+    AsioContextPool(const AsioContextPool&) = delete;
+    AsioContextPool& operator=(const AsioContextPool&) = delete;
+
+    /** get the number of contexts in the pool*/
+    std::size_t size() const { return managers.size(); }
+    /** get the base name of the contexts*/
+    const std::string& getName() const { return name; }
+    /** get the contexts in turn*/
+    asio::io_context& nextContext();
+    /** get the context for a key, the same key always selects the same
+     * context*/
+    asio::io_context& getContext(std::size_t key);
+    /** get the context for a string key such as an address*/
+    asio::io_context& getContext(const std::string& key);
+    /** get the manager for one of the contexts
+    @throws std::out_of_range if the index is not valid*/
+    std::shared_ptr<AsioContextManager> getContextManager(
+        std::size_t index) const;
+
+    /** start the loops of all the contexts*/
+    void start();
+    /** stop the loops of all the contexts once they have no more work*/
+    void stop();
+    /** check if the context loops have been started*/
+    bool isRunning() const;
+
+  private:
+    explicit AsioContextPool(std::string poolName) : name(std::move(poolName))
+    {
+    }
+
+    std::string name;
+    std::vector<std::shared_ptr<AsioContextManager>> managers;
+    std::atomic<std::size_t> nextIndex{0};
+    mutable std::mutex loopLock;  //!< protects loops
+    std::vector<AsioContextManager::LoopHandle> loops;
+};
+}  // namespace gmlc::networking
@@ -0,0 +1,276 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "KernelTls.hpp"
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+namespace gmlc::networking {
+namespace {
+    /// what is known about the records a connection has sent
+    struct TransmitState {
+        std::vector<unsigned char> secret;  //!< the application traffic secret
+        std::uint64_t records{0};  //!< records sent with the secret
+        bool keyed{false};
+    };
+
+    void freeTransmitState(
+        void* /*parent*/,
+        void* ptr,
+        CRYPTO_EX_DATA* /*ad*/,
+        int /*idx*/,
+        long /*argl*/,  // NOLINT
+        void* /*argp*/)
+    {
+        auto* state = static_cast<TransmitState*>(ptr);
+        if (state != nullptr) {
+            OPENSSL_cleanse(state->secret.data(), state->secret.size());
+            delete state;
+        }
+    }
+
+    int transmitStateIndex()
+    {
+        static const int index = SSL_get_ex_new_index(
+            0, nullptr, nullptr, nullptr, freeTransmitState);
+        return index;
+    }
+
+    TransmitState* transmitState(const SSL* ssl)
+    {
+        return static_cast<TransmitState*>(
+            SSL_get_ex_data(ssl, transmitStateIndex()));
+    }
+
+    int hexValue(char digit)
+    {
+        if (digit >= '0' && digit <= '9') {
+            return digit - '0';
+        }
+        if (digit >= 'a' && digit <= 'f') {
+            return digit - 'a' + 10;
+        }
+        if (digit >= 'A' && digit <= 'F') {
+            return digit - 'A' + 10;
+        }
+        return 0;
+    }
+
+    // the secret for sending is logged when OpenSSL switches to it, the
+    // records written from then on use it
+    void keyLog(const SSL* ssl, const char* line)
+    {
+        auto* state = transmitState(ssl);
+        if (state == nullptr) {
+            return;
+        }
+        const std::string_view label = (SSL_is_server(ssl) == 1) ?
+            "SERVER_TRAFFIC_SECRET_0 " :
+            "CLIENT_TRAFFIC_SECRET_0 ";
+        const std::string_view entry(line);
+        if (entry.compare(0, label.size(), label) != 0) {
+            return;
+        }
+        // the label is followed by the client random and the secret in hex
+        const auto hex = entry.substr(entry.rfind(' ') + 1);
+        state->secret.clear();
+        for (size_t ii = 0; ii + 1 < hex.size(); ii += 2) {
+            state->secret.push_back(static_cast<unsigned char>(
+                hexValue(hex[ii]) * 16 + hexValue(hex[ii + 1])));
+        }
+        state->records = 0;
+        state->keyed = true;
+    }
+
+    void recordWritten(
+        int writing,
+        int /*version*/,
+        int contentType,
+        const void* /*buf*/,
+        size_t /*len*/,
+        SSL* ssl,
+        void* /*arg*/)
+    {
+        if (writing == 0 || contentType != SSL3_RT_HEADER) {
+            return;
+        }
+        auto* state = transmitState(ssl);
+        if (state != nullptr && state->keyed) {
+            ++state->records;
+        }
+    }
+
+    /** HKDF-Expand-Label from RFC 8446 with an empty context*/
+    bool expandLabel(
+        const EVP_MD* digest,
+        const std::vector<unsigned char>& secret,
+        const std::string& label,
+        unsigned char* output,
+        size_t length)
+    {
+        const std::string fullLabel = "tls13 " + label;
+        std::vector<unsigned char> info;
+        info.push_back(static_cast<unsigned char>(length >> 8U));
+        info.push_back(static_cast<unsigned char>(length & 0xFFU));
+        info.push_back(static_cast<unsigned char>(fullLabel.size()));
+        info.insert(info.end(), fullLabel.begin(), fullLabel.end());
+        info.push_back(0);
+
+        std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> context(
+            EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr), &EVP_PKEY_CTX_free);
+        size_t outputLength = length;
+        return context && EVP_PKEY_derive_init(context.get()) > 0 &&
+            EVP_PKEY_CTX_hkdf_mode(
+                context.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0 &&
+            EVP_PKEY_CTX_set_hkdf_md(context.get(), digest) > 0 &&
+            EVP_PKEY_CTX_set1_hkdf_key(
+                context.get(),
+                secret.data(),
+                static_cast<int>(secret.size())) > 0 &&
+            EVP_PKEY_CTX_add1_hkdf_info(
+                context.get(), info.data(), static_cast<int>(info.size())) >
+            0 &&
+            EVP_PKEY_derive(context.get(), output, &outputLength) > 0 &&
+            outputLength == length;
+    }
+
+#ifdef __linux__
+    template<class CryptoInfo>
+    std::error_code
+        setTransmit(int descriptor, const KernelTlsParameters& parameters)
+    {
+        CryptoInfo info;
+        std::memset(&info, 0, sizeof(info));
+        info.info.version = TLS_1_3_VERSION;
+        info.info.cipher_type = (sizeof(info.key) == 16) ?
+            TLS_CIPHER_AES_GCM_128 :
+            TLS_CIPHER_AES_GCM_256;
+        std::memcpy(info.key, parameters.key.data(), sizeof(info.key));
+        std::memcpy(info.salt, parameters.iv.data(), sizeof(info.salt));
+        std::memcpy(
+            info.iv, parameters.iv.data() + sizeof(info.salt), sizeof(info.iv));
+        for (size_t ii = 0; ii < sizeof(info.rec_seq); ++ii) {
+            info.rec_seq[ii] = static_cast<unsigned char>(
+                parameters.sequence >> (8U * (sizeof(info.rec_seq) - 1 - ii)));
+        }
+        std::error_code result;
+        if (setsockopt(descriptor, SOL_TLS, TLS_TX, &info, sizeof(info)) !=
+            0) {
+            result = std::error_code(errno, std::system_category());
+        }
+        OPENSSL_cleanse(&info, sizeof(info));
+        return result;
+    }
+#endif
+}  // namespace
+
+void KernelTls::enableTracking(SSL_CTX* context)
+{
+    SSL_CTX_set_keylog_callback(context, &keyLog);
+}
+
+void KernelTls::track(SSL* ssl)
+{
+    if (transmitState(ssl) != nullptr) {
+        return;
+    }
+    auto* state = new TransmitState();
+    if (SSL_set_ex_data(ssl, transmitStateIndex(), state) != 1) {
+        delete state;
+        return;
+    }
+    SSL_set_msg_callback(ssl, &recordWritten);
+}
+
+bool KernelTls::transmitParameters(SSL* ssl, KernelTlsParameters& parameters)
+{
+    auto* state = transmitState(ssl);
+    if (state == nullptr || !state->keyed || SSL_is_init_finished(ssl) != 1 ||
+        SSL_version(ssl) != TLS1_3_VERSION) {
+        return false;
+    }
+    const EVP_MD* digest{nullptr};
+    size_t keySize{0};
+    switch (SSL_CIPHER_get_id(SSL_get_current_cipher(ssl))) {
+        case TLS1_3_CK_AES_128_GCM_SHA256:
+            digest = EVP_sha256();
+            keySize = 16;
+            break;
+        case TLS1_3_CK_AES_256_GCM_SHA384:
+            digest = EVP_sha384();
+            keySize = 32;
+            break;
+        default:
+            return false;
+    }
+    parameters.key.resize(keySize);
+    if (!expandLabel(
+            digest, state->secret, "key", parameters.key.data(), keySize) ||
+        !expandLabel(
+            digest,
+            state->secret,
+            "iv",
+            parameters.iv.data(),
+            parameters.iv.size())) {
+        OPENSSL_cleanse(parameters.key.data(), parameters.key.size());
+        return false;
+    }
+    parameters.sequence = state->records;
+    return true;
+}
+
+std::error_code KernelTls::enableTransmit(SSL* ssl, int descriptor)
+{
+#ifdef __linux__
+    KernelTlsParameters parameters;
+    if (!transmitParameters(ssl, parameters)) {
+        return std::make_error_code(std::errc::operation_not_supported);
+    }
+    std::error_code result;
+    if (setsockopt(descriptor, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+        // the tls module is not loaded or not built into the kernel
+        result = std::error_code(errno, std::system_category());
+    } else if (parameters.key.size() == 16) {
+        result = setTransmit<tls12_crypto_info_aes_gcm_128>(
+            descriptor, parameters);
+    } else {
+        result = setTransmit<tls12_crypto_info_aes_gcm_256>(
+            descriptor, parameters);
+    }
+    OPENSSL_cleanse(parameters.key.data(), parameters.key.size());
+    OPENSSL_cleanse(parameters.iv.data(), parameters.iv.size());
+    return result;
+#else
+    (void)ssl;
+    (void)descriptor;
+    return std::make_error_code(std::errc::operation_not_supported);
+#endif
+}
+
+}  // namespace gmlc::networking
+#endif
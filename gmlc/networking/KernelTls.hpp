@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+#include <array>
+#include <cstdint>
+#include <openssl/ssl.h>
+#include <system_error>
+#include <vector>
+
+/** @file
+moving the encryption of sent TLS records into the linux kernel
+*/
+namespace gmlc::networking {
+/** the state the kernel needs to encrypt the records a connection sends*/
+struct KernelTlsParameters {
+    std::vector<unsigned char> key;
+    std::array<unsigned char, 12> iv{};  //!< the salt followed by the iv
+    std::uint64_t sequence{0};  //!< the sequence number of the next record
+};
+
+/** hand the encryption of the records a TLS connection sends to the kernel
+@details OpenSSL only enables kernel TLS itself when it owns the socket, asio
+streams feed OpenSSL through a memory BIO so the traffic secret is captured
+from the key log callback and the records written with it are counted.  After
+the handshake the key and the next sequence number are given to the kernel
+and data is written to the socket directly.  Only TLS 1.3 with the AES-GCM
+cipher suites is supported.  Received records are still decrypted by OpenSSL,
+so a key update requested by the peer is not supported.
+*/
+class KernelTls {
+  public:
+    /** set up an ssl context so its tracked connections capture their
+     * traffic secrets*/
+    static void enableTracking(SSL_CTX* context);
+    /** start tracking the records a connection sends, must be called before
+     * the handshake*/
+    static void track(SSL* ssl);
+    /** get the key, iv, and next sequence number of the records a connection
+    sends
+    @return false if the connection is not tracked, the handshake has not
+    completed, or the protocol or cipher suite is not supported*/
+    static bool transmitParameters(SSL* ssl, KernelTlsParameters& parameters);
+    /** move the encryption of sent records to the kernel
+    @param ssl a tracked connection that has completed its handshake
+    @param descriptor the tcp socket of the connection
+    @return an error if the connection, platform, or kernel does not support
+    it, the connection is unchanged in that case*/
+    static std::error_code enableTransmit(SSL* ssl, int descriptor);
+};
+}  // namespace gmlc::networking
+#endif
@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "LatencyHistogram.hpp"
+
+#include <cmath>
+
+namespace gmlc::networking {
+
+static int highestBit(std::uint64_t value)
+{
+    int bit{0};
+    for (int shift = 32; shift > 0; shift /= 2) {
+        if ((value >> shift) != 0) {
+            value >>= shift;
+            bit += shift;
+        }
+    }
+    return bit;
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t value)
+{
+    if (value < subBucketCount) {
+        return static_cast<std::size_t>(value);
+    }
+    // the top subBucketBits+1 bits select the bucket
+    const int shift = highestBit(value) - subBucketBits;
+    return static_cast<std::size_t>(shift + 1) * subBucketCount +
+        static_cast<std::size_t>((value >> shift) - subBucketCount);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index)
+{
+    if (index < subBucketCount) {
+        return index;
+    }
+    const auto shift = static_cast<int>(index / subBucketCount) - 1;
+    const std::uint64_t lower = (subBucketCount + index % subBucketCount)
+        << shift;
+    return lower + ((std::uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t nanoseconds)
+{
+    constexpr auto order = std::memory_order_relaxed;
+    buckets[bucketIndex(nanoseconds)].fetch_add(1, order);
+    total.fetch_add(nanoseconds, order);
+    auto current = maxValue.load(order);
+    while (nanoseconds > current &&
+           !maxValue.compare_exchange_weak(current, nanoseconds, order)) {
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    constexpr auto order = std::memory_order_relaxed;
+    for (std::size_t ii = 0; ii < bucketCount; ++ii) {
+        auto value = other.buckets[ii].load(order);
+        if (value != 0) {
+            buckets[ii].fetch_add(value, order);
+        }
+    }
+    total.fetch_add(other.total.load(order), order);
+    auto otherMax = other.maxValue.load(order);
+    auto current = maxValue.load(order);
+    while (otherMax > current &&
+           !maxValue.compare_exchange_weak(current, otherMax, order)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    constexpr auto order = std::memory_order_relaxed;
+    for (auto& bucket : buckets) {
+        bucket.store(0, order);
+    }
+    total.store(0, order);
+    maxValue.store(0, order);
+}
+
+std::uint64_t LatencyHistogram::count() const
+{
+    std::uint64_t sum{0};
+    for (const auto& bucket : buckets) {
+        sum += bucket.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+double LatencyHistogram::mean() const
+{
+    auto recorded = count();
+    if (recorded == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(total.load(std::memory_order_relaxed)) /
+        static_cast<double>(recorded);
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    // take a single snapshot so the count and the buckets agree
+    std::array<std::uint64_t, bucketCount> snapshot;
+    std::uint64_t recorded{0};
+    for (std::size_t ii = 0; ii < bucketCount; ++ii) {
+        snapshot[ii] = buckets[ii].load(std::memory_order_relaxed);
+        recorded += snapshot[ii];
+    }
+    if (recorded == 0) {
+        return 0;
+    }
+    if (fraction < 0.0) {
+        fraction = 0.0;
+    } else if (fraction > 1.0) {
+        fraction = 1.0;
+    }
+    auto rank = static_cast<std::uint64_t>(
+        std::ceil(fraction * static_cast<double>(recorded)));
+    if (rank == 0) {
+        rank = 1;
+    }
+    std::uint64_t seen{0};
+    const auto largest = max();
+    for (std::size_t ii = 0; ii < bucketCount; ++ii) {
+        seen += snapshot[ii];
+        if (seen >= rank) {
+            auto bound = bucketUpperBound(ii);
+            return (largest != 0 && bound > largest) ? largest : bound;
+        }
+    }
+    return largest;
+}
+
+}  // namespace gmlc::networking
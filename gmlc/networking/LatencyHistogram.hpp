@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/** @file
+log-linear histograms for recording operation latencies
+*/
+namespace gmlc::networking {
+/// false if the library was built with latency histograms compiled out
+#ifdef GMLC_NETWORKING_DISABLE_HISTOGRAMS
+constexpr bool latencyHistogramsEnabled{false};
+#else
+constexpr bool latencyHistogramsEnabled{true};
+#endif
+
+/** a fixed size histogram of durations in nanoseconds
+@details each power of two range is split into 16 linear buckets so the value
+reported for a percentile is within about 6% of the recorded value.  Every
+bucket is an atomic counter updated with relaxed ordering, so recording never
+locks and any number of threads may record and merge concurrently.
+*/
+class LatencyHistogram {
+  public:
+    /// log2 of the number of linear buckets per power of two
+    static constexpr int subBucketBits{4};
+    static constexpr std::uint64_t subBucketCount{1U << subBucketBits};
+    /// enough buckets to hold any 64 bit value
+    static constexpr std::size_t bucketCount{
+        (64 - subBucketBits + 1) * subBucketCount};
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /** record a single duration in nanoseconds*/
+    void record(std::uint64_t nanoseconds);
+    /** record a duration*/
+    void record(std::chrono::nanoseconds duration)
+    {
+        record(static_cast<std::uint64_t>(
+            (duration.count() > 0) ? duration.count() : 0));
+    }
+    /** add the contents of another histogram to this one
+    @details the other histogram may still be recording, values recorded
+    during the merge may or may not be included*/
+    void merge(const LatencyHistogram& other);
+    /** clear all recorded values*/
+    void reset();
+
+    /** get the number of recorded values*/
+    std::uint64_t count() const;
+    /** get the largest recorded value in nanoseconds*/
+    std::uint64_t max() const
+    {
+        return maxValue.load(std::memory_order_relaxed);
+    }
+    /** get the mean of the recorded values in nanoseconds*/
+    double mean() const;
+    /** get the value in nanoseconds at or below which the given fraction of
+    recorded values fall
+    @param fraction the percentile as a fraction 0.5 for the median, 0.999 for
+    the 99.9th percentile
+    @return the upper end of the bucket holding the percentile, or 0 if
+    nothing is recorded*/
+    std::uint64_t percentile(double fraction) const;
+
+    /** get the bucket index for a value*/
+    static std::size_t bucketIndex(std::uint64_t value);
+    /** get the largest value that is stored in a bucket*/
+    static std::uint64_t bucketUpperBound(std::size_t index);
+
+  private:
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets{};
+    std::atomic<std::uint64_t> total{0};  //!< sum of recorded values
+    std::atomic<std::uint64_t> maxValue{0};
+};
+
+/** the histograms kept for a connection or a group of connections*/
+struct LatencyHistograms {
+    /// time spent in the data, message, and error callbacks
+    LatencyHistogram callback;
+    /// time spent in blocking send calls
+    LatencyHistogram send;
+    /// delay from a read completing to the callback being called
+    LatencyHistogram dispatch;
+
+    /** add the contents of another set of histograms*/
+    void merge(const LatencyHistograms& other)
+    {
+        callback.merge(other.callback);
+        send.merge(other.send);
+        dispatch.merge(other.dispatch);
+    }
+    /** clear all the histograms*/
+    void reset()
+    {
+        callback.reset();
+        send.reset();
+        dispatch.reset();
+    }
+};
+
+/** record the lifetime of the object in a histogram
+@details does nothing, including reading the clock, if the histogram is null
+or histograms are compiled out*/
+class ScopedLatency {
+  public:
+    explicit ScopedLatency(LatencyHistogram* histogram) :
+        target(latencyHistogramsEnabled ? histogram : nullptr)
+    {
+        if (target != nullptr) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~ScopedLatency()
+    {
+        if (target != nullptr) {
+            target->record(std::chrono::steady_clock::now() - start);
+        }
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+  private:
+    LatencyHistogram* target;
+    std::chrono::steady_clock::time_point start;
+};
+}  // namespace gmlc::networking
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "MessageFraming.hpp"
+
+namespace gmlc::networking {
+
+std::size_t encodeFrameHeader(
+    FramingMode mode,
+    std::uint64_t messageLength,
+    char* header)
+{
+    switch (mode) {
+        case FramingMode::NONE:
+        default:
+            return 0;
+        case FramingMode::FIXED32:
+        case FramingMode::FIXED64: {
+            if (mode == FramingMode::FIXED32 &&
+                messageLength > (std::numeric_limits<std::uint32_t>::max)()) {
+                return 0;
+            }
+            auto headerSize = static_cast<std::size_t>(mode);
+            for (std::size_t ii = headerSize; ii > 0; --ii) {
+                header[ii - 1] = static_cast<char>(messageLength & 0xFFU);
+                messageLength >>= 8U;
+            }
+            return headerSize;
+        }
+        case FramingMode::VARINT: {
+            std::size_t headerSize{0};
+            while (messageLength >= 0x80U) {
+                header[headerSize++] =
+                    static_cast<char>((messageLength & 0x7FU) | 0x80U);
+                messageLength >>= 7U;
+            }
+            header[headerSize++] = static_cast<char>(messageLength);
+            return headerSize;
+        }
+    }
+}
+
+std::size_t decodeFrameHeader(
+    FramingMode mode,
+    const char* data,
+    std::size_t dataLength,
+    std::uint64_t& messageLength)
+{
+    switch (mode) {
+        case FramingMode::NONE:
+        default:
+            messageLength = dataLength;
+            return 0;
+        case FramingMode::FIXED32:
+        case FramingMode::FIXED64: {
+            auto headerSize = static_cast<std::size_t>(mode);
+            if (dataLength < headerSize) {
+                return 0;
+            }
+            std::uint64_t length{0};
+            for (std::size_t ii = 0; ii < headerSize; ++ii) {
+                length = (length << 8U) |
+                    static_cast<std::uint64_t>(
+                             static_cast<unsigned char>(data[ii]));
+            }
+            messageLength = length;
+            return headerSize;
+        }
+        case FramingMode::VARINT: {
+            std::uint64_t length{0};
+            for (std::size_t ii = 0; ii < maxFrameHeaderSize; ++ii) {
+                if (ii >= dataLength) {
+                    return 0;
+                }
+                auto byte = static_cast<unsigned char>(data[ii]);
+                length |= static_cast<std::uint64_t>(byte & 0x7FU) << (7U * ii);
+                if ((byte & 0x80U) == 0) {
+                    messageLength = length;
+                    return ii + 1;
+                }
+            }
+            return invalidFrameHeader;
+        }
+    }
+}
+
+}  // namespace gmlc::networking
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <system_error>
+
+/** @file
+functions for length prefixed message framing on a byte stream
+*/
+namespace gmlc::networking {
+/** define the format of the length header placed in front of each message*/
+enum class FramingMode : char {
+    NONE = 0,  //!< no framing, the data callback sees the raw stream
+    VARINT = 1,  //!< variable length unsigned integer (LEB128)
+    FIXED32 = 4,  //!< 4 byte big endian length
+    FIXED64 = 8,  //!< 8 byte big endian length
+};
+
+/// the largest header any framing mode produces
+constexpr std::size_t maxFrameHeaderSize{10};
+/// value returned from decodeFrameHeader if the header is not valid
+constexpr std::size_t invalidFrameHeader{
+    (std::numeric_limits<std::size_t>::max)()};
+
+/** write the length header for a message
+@param mode the framing mode to use
+@param messageLength the length of the message following the header
+@param header location to write the header, must have room for
+maxFrameHeaderSize bytes
+@return the number of bytes written to header, 0 if the mode is NONE or the
+length cannot be represented by the mode
+*/
+std::size_t encodeFrameHeader(
+    FramingMode mode,
+    std::uint64_t messageLength,
+    char* header);
+
+/** read a length header from the start of a block of data
+@param mode the framing mode to use
+@param data the received data
+@param dataLength the number of bytes available in data
+@param[out] messageLength the length of the message following the header
+@return the size of the header, 0 if more data is needed to complete the
+header, or invalidFrameHeader if the data is not a valid header
+*/
+std::size_t decodeFrameHeader(
+    FramingMode mode,
+    const char* data,
+    std::size_t dataLength,
+    std::uint64_t& messageLength);
+
+/** find all the complete messages in a block of data
+@details the callback is called with a pointer into data and the length of each
+message, no data is copied.  Parsing stops at the first incomplete message.
+@param mode the framing mode to use
+@param data the received data
+@param dataLength the number of bytes available in data
+@param maxMessageLength the largest message length accepted
+@param messageCallback callable with signature void(const char*, size_t)
+@param[out] error set to std::errc::message_size if a message is longer than
+maxMessageLength or std::errc::bad_message if a header is invalid
+@return the number of bytes used by complete messages
+*/
+template<class Callback>
+std::size_t parseFrames(
+    FramingMode mode,
+    const char* data,
+    std::size_t dataLength,
+    std::uint64_t maxMessageLength,
+    Callback&& messageCallback,
+    std::error_code& error)
+{
+    std::size_t used{0};
+    while (used < dataLength) {
+        std::uint64_t messageLength{0};
+        auto headerSize = decodeFrameHeader(
+            mode, data + used, dataLength - used, messageLength);
+        if (headerSize == 0) {
+            break;
+        }
+        if (headerSize == invalidFrameHeader) {
+            error = std::make_error_code(std::errc::bad_message);
+            break;
+        }
+        if (messageLength > maxMessageLength) {
+            error = std::make_error_code(std::errc::message_size);
+            break;
+        }
+        if (dataLength - used - headerSize < messageLength) {
+            break;
+        }
+        messageCallback(
+            data + used + headerSize, static_cast<std::size_t>(messageLength));
+        used += headerSize + static_cast<std::size_t>(messageLength);
+    }
+    return used;
+}
+}  // namespace gmlc::networking
@@ -0,0 +1,219 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "MirroredBuffer.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace gmlc::networking {
+
+#ifdef _WIN32
+static std::system_error lastSystemError(const char* message)
+{
+    return std::system_error(
+        static_cast<int>(GetLastError()), std::system_category(), message);
+}
+#else
+static std::system_error lastSystemError(const char* message)
+{
+    return std::system_error(errno, std::system_category(), message);
+}
+#endif
+
+std::size_t MirroredBuffer::granularity()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<std::size_t>(info.dwAllocationGranularity);
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+bool MirroredBuffer::isSupported()
+{
+    static const bool supported = []() {
+        try {
+            MirroredBuffer test(1);
+            return true;
+        }
+        catch (const std::system_error&) {
+            return false;
+        }
+    }();
+    return supported;
+}
+
+MirroredBuffer::MirroredBuffer(std::size_t minimumCapacity)
+{
+    const auto gran = granularity();
+    std::size_t cap = (minimumCapacity == 0) ? 1 : minimumCapacity;
+    cap = ((cap + gran - 1) / gran) * gran;
+#ifdef _WIN32
+    const auto total = static_cast<unsigned long long>(cap) * 2ULL;
+    HANDLE mapping = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        nullptr,
+        PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<unsigned long long>(cap) >> 32U),
+        static_cast<DWORD>(cap & 0xFFFFFFFFULL),
+        nullptr);
+    if (mapping == nullptr) {
+        throw lastSystemError("unable to create mirrored buffer mapping");
+    }
+    // there is no way to atomically reserve a region and map into it without
+    // the newer placeholder API, so find a free region and retry if another
+    // thread grabs it in between
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        void* region = VirtualAlloc(
+            nullptr, static_cast<SIZE_T>(total), MEM_RESERVE, PAGE_NOACCESS);
+        if (region == nullptr) {
+            break;
+        }
+        VirtualFree(region, 0, MEM_RELEASE);
+        auto* first = static_cast<char*>(MapViewOfFileEx(
+            mapping, FILE_MAP_ALL_ACCESS, 0, 0, cap, region));
+        if (first == nullptr) {
+            continue;
+        }
+        auto* second = static_cast<char*>(MapViewOfFileEx(
+            mapping, FILE_MAP_ALL_ACCESS, 0, 0, cap, first + cap));
+        if (second == nullptr) {
+            UnmapViewOfFile(first);
+            continue;
+        }
+        base = first;
+        bufferCapacity = cap;
+        mappingHandle = mapping;
+        return;
+    }
+    CloseHandle(mapping);
+    throw std::system_error(
+        std::make_error_code(std::errc::not_enough_memory),
+        "unable to map mirrored buffer");
+#else
+    int fd{-1};
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    fd = memfd_create("gmlc_mirrored_buffer", MFD_CLOEXEC);
+#endif
+    if (fd < 0) {
+        static std::atomic<unsigned int> bufferCounter{0};
+        const std::string name = "/gmlc_mb_" + std::to_string(getpid()) +
+            "_" + std::to_string(bufferCounter++);
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            throw lastSystemError("unable to create mirrored buffer file");
+        }
+        // only the descriptor is needed, the name can go away immediately
+        shm_unlink(name.c_str());
+    }
+    if (ftruncate(fd, static_cast<off_t>(cap)) != 0) {
+        auto err = lastSystemError("unable to size mirrored buffer");
+        ::close(fd);
+        throw err;
+    }
+    void* region = mmap(
+        nullptr, cap * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        auto err = lastSystemError("unable to reserve mirrored buffer");
+        ::close(fd);
+        throw err;
+    }
+    auto* first = static_cast<char*>(region);
+    if (mmap(
+            first,
+            cap,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_FIXED,
+            fd,
+            0) == MAP_FAILED ||
+        mmap(
+            first + cap,
+            cap,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_FIXED,
+            fd,
+            0) == MAP_FAILED) {
+        auto err = lastSystemError("unable to map mirrored buffer");
+        munmap(region, cap * 2);
+        ::close(fd);
+        throw err;
+    }
+    // the mappings keep the memory alive
+    ::close(fd);
+    base = first;
+    bufferCapacity = cap;
+#endif
+}
+
+MirroredBuffer::~MirroredBuffer()
+{
+    release();
+}
+
+MirroredBuffer::MirroredBuffer(MirroredBuffer&& other) noexcept :
+    base(std::exchange(other.base, nullptr)),
+    bufferCapacity(std::exchange(other.bufferCapacity, 0)),
+    head(std::exchange(other.head, 0)), count(std::exchange(other.count, 0))
+#ifdef _WIN32
+    ,
+    mappingHandle(std::exchange(other.mappingHandle, nullptr))
+#endif
+{
+}
+
+MirroredBuffer& MirroredBuffer::operator=(MirroredBuffer&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        base = std::exchange(other.base, nullptr);
+        bufferCapacity = std::exchange(other.bufferCapacity, 0);
+        head = std::exchange(other.head, 0);
+        count = std::exchange(other.count, 0);
+#ifdef _WIN32
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MirroredBuffer::release() noexcept
+{
+    if (base == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(base + bufferCapacity);
+    UnmapViewOfFile(base);
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+#else
+    munmap(base, bufferCapacity * 2);
+#endif
+    base = nullptr;
+    bufferCapacity = 0;
+    head = 0;
+    count = 0;
+}
+
+}  // namespace gmlc::networking
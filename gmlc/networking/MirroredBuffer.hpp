@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <cstddef>
+
+/** @file
+ring buffer backed by a block of memory mapped twice into consecutive virtual
+address ranges, so any region of the ring can be accessed as a contiguous block
+*/
+namespace gmlc::networking {
+/** ring buffer using mirrored virtual memory
+@details the storage is mapped at base and again at base+capacity so the stored
+data and the free space are each always contiguous in memory, regardless of
+where they wrap around the end of the ring.  Consuming data is just an update of
+the read position, no data is ever moved.
+*/
+class MirroredBuffer {
+  public:
+    /** create a buffer with at least the requested capacity
+    @details the capacity is rounded up to the page (or allocation) granularity
+    of the platform
+    @throws std::system_error if the mapping could not be created
+    */
+    explicit MirroredBuffer(std::size_t minimumCapacity);
+    /** destructor releasing the mappings*/
+    ~MirroredBuffer();
+    MirroredBuffer(const MirroredBuffer&) = delete;
+    MirroredBuffer& operator=(const MirroredBuffer&) = delete;
+    MirroredBuffer(MirroredBuffer&& other) noexcept;
+    MirroredBuffer& operator=(MirroredBuffer&& other) noexcept;
+
+    /** check if mirrored buffers are available on the current platform*/
+    static bool isSupported();
+    /** get the granularity the buffer capacity is rounded to*/
+    static std::size_t granularity();
+
+    /** get the total capacity of the buffer*/
+    std::size_t capacity() const { return bufferCapacity; }
+    /** get the number of bytes currently stored in the buffer*/
+    std::size_t size() const { return count; }
+    /** get the number of bytes that can be written into the buffer*/
+    std::size_t freeSpace() const { return bufferCapacity - count; }
+    /** check if the buffer has no data*/
+    bool empty() const { return count == 0; }
+    /** pointer to the start of the stored data, size() bytes are contiguous*/
+    char* data() { return base + head; }
+    const char* data() const { return base + head; }
+    /** pointer to the location for the next write, freeSpace() bytes are
+     * contiguous*/
+    char* writeLocation() { return base + head + count; }
+    /** mark bytes as written at the write location
+    @param bytes the number of bytes written must be <= freeSpace()*/
+    void commit(std::size_t bytes) { count += bytes; }
+    /** remove bytes from the front of the stored data
+    @param bytes the number of bytes to remove, must be <=size()*/
+    void consume(std::size_t bytes)
+    {
+        count -= bytes;
+        head = (count == 0) ? 0 : ((head + bytes) % bufferCapacity);
+    }
+    /** remove all the stored data*/
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+  private:
+    void release() noexcept;
+
+    char* base{nullptr};  //!< the start of the first mapping
+    std::size_t bufferCapacity{0};  //!< the size of each mapping
+    std::size_t head{0};  //!< offset of the first stored byte
+    std::size_t count{0};  //!< the number of stored bytes
+#ifdef _WIN32
+    void* mappingHandle{nullptr};  //!< the handle to the file mapping object
+#endif
+};
+
+}  // namespace gmlc::networking
@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "ResolutionCache.h"
+
+#include <utility>
+
+namespace gmlc::networking {
+
+std::shared_ptr<ResolutionCache> ResolutionCache::instance()
+{
+    static const std::shared_ptr<ResolutionCache> cache(new ResolutionCache());
+    return cache;
+}
+
+std::string ResolutionCache::makeKey(
+    const asio::ip::tcp& protocol,
+    const std::string& host,
+    const std::string& service,
+    asio::ip::resolver_base::flags flags)
+{
+    std::string key = host;
+    key.push_back('\n');
+    key.append(service);
+    key.push_back('\n');
+    key.append(std::to_string(protocol.family()));
+    key.push_back('\n');
+    key.append(std::to_string(static_cast<int>(flags)));
+    return key;
+}
+
+bool ResolutionCache::lookup(
+    const std::string& key,
+    std::error_code& ec,
+    results_type& results) const
+{
+    auto fnd = entries.find(key);
+    if (fnd == entries.end() || fnd->second.pending ||
+        fnd->second.expiration <= std::chrono::steady_clock::now()) {
+        return false;
+    }
+    ec = fnd->second.error;
+    results = fnd->second.results;
+    return true;
+}
+
+std::vector<ResolutionCache::ResolveHandler> ResolutionCache::store(
+    const std::string& key,
+    const std::string& host,
+    const std::error_code& ec,
+    const results_type& results)
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<ResolveHandler> handlers;
+    std::lock_guard<std::mutex> cacheLock(lock);
+    // expired entries are only removed when something new is stored so a
+    // lookup never has to modify the table
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!it->second.pending && it->second.expiration <= now &&
+            it->first != key) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto& entry = entries[key];
+    entry.host = host;
+    entry.error = ec;
+    entry.results = (ec) ? results_type() : results;
+    entry.expiration =
+        now + ((ec) ? negativeTimeToLive.load() : timeToLive.load());
+    entry.pending = false;
+    handlers.swap(entry.waiting);
+    return handlers;
+}
+
+ResolutionCache::results_type ResolutionCache::resolve(
+    asio::io_context& io_context,
+    const asio::ip::tcp& protocol,
+    const std::string& host,
+    const std::string& service,
+    std::error_code& ec,
+    asio::ip::resolver_base::flags flags)
+{
+    const auto key = makeKey(protocol, host, service, flags);
+    results_type results;
+    {
+        std::lock_guard<std::mutex> cacheLock(lock);
+        if (lookup(key, ec, results)) {
+            return results;
+        }
+    }
+    ++resolutions;
+    asio::ip::tcp::resolver resolver(io_context);
+    ec.clear();
+    results = resolver.resolve(protocol, host, service, flags, ec);
+    // an asynchronous resolution of the same name may be waiting, this
+    // answers it as well
+    auto handlers = store(key, host, ec, results);
+    for (auto& handler : handlers) {
+        handler(ec, results);
+    }
+    return (ec) ? results_type() : results;
+}
+
+void ResolutionCache::asyncResolve(
+    asio::io_context& io_context,
+    const asio::ip::tcp& protocol,
+    const std::string& host,
+    const std::string& service,
+    ResolveHandler handler,
+    asio::ip::resolver_base::flags flags)
+{
+    auto key = makeKey(protocol, host, service, flags);
+    {
+        std::error_code ec;
+        results_type results;
+        std::unique_lock<std::mutex> cacheLock(lock);
+        if (lookup(key, ec, results)) {
+            cacheLock.unlock();
+            handler(ec, results);
+            return;
+        }
+        auto& entry = entries[key];
+        entry.waiting.push_back(std::move(handler));
+        if (entry.pending) {
+            return;
+        }
+        entry.host = host;
+        entry.pending = true;
+    }
+    ++resolutions;
+    // the resolver lives in its own handler so the resolution does not
+    // depend on the lifetime of the request that started it
+    auto resolver = std::make_shared<asio::ip::tcp::resolver>(io_context);
+    resolver->async_resolve(
+        protocol,
+        host,
+        service,
+        flags,
+        [cache = shared_from_this(), resolver, key = std::move(key), host](
+            const std::error_code& error, const results_type& results) {
+            auto handlers = cache->store(key, host, error, results);
+            for (auto& waiting : handlers) {
+                waiting(error, results);
+            }
+        });
+}
+
+void ResolutionCache::remove(const std::string& host)
+{
+    std::lock_guard<std::mutex> cacheLock(lock);
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!it->second.pending && it->second.host == host) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ResolutionCache::clear()
+{
+    std::lock_guard<std::mutex> cacheLock(lock);
+    // pending entries hold handlers that are still owed an answer
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!it->second.pending) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::size_t ResolutionCache::size() const
+{
+    std::lock_guard<std::mutex> cacheLock(lock);
+    return entries.size();
+}
+
+}  // namespace gmlc::networking
@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace gmlc::networking {
+/** a process wide cache of host name resolutions
+@details resolutions are keyed by host, service, protocol family, and resolver
+flags.  Successful resolutions are kept for the time to live and failures for
+the negative time to live so repeated connections to the same host, such as
+many federates connecting to one broker or a connection being retried, resolve
+the name once.  Asynchronous requests for a name that is already being
+resolved wait for that resolution instead of starting another one.
+*/
+class ResolutionCache : public std::enable_shared_from_this<ResolutionCache> {
+  public:
+    using results_type = asio::ip::tcp::resolver::results_type;
+    using ResolveHandler =
+        std::function<void(const std::error_code&, const results_type&)>;
+    static constexpr std::chrono::milliseconds defaultTimeToLive{60000};
+    static constexpr std::chrono::milliseconds defaultNegativeTimeToLive{2000};
+
+    /** get the cache shared by the process*/
+    static std::shared_ptr<ResolutionCache> instance();
+    ResolutionCache(const ResolutionCache&) = delete;
+    ResolutionCache& operator=(const ResolutionCache&) = delete;
+
+    /** resolve a host and service, blocking on a cache miss
+    @param io_context the context used to construct the resolver
+    @param protocol the protocol family of the addresses
+    @param host the host name or address
+    @param service the service name or port number
+    @param ec set to the error if the resolution failed
+    @param flags the resolver flags
+    @return the resolved endpoints, empty on error*/
+    results_type resolve(
+        asio::io_context& io_context,
+        const asio::ip::tcp& protocol,
+        const std::string& host,
+        const std::string& service,
+        std::error_code& ec,
+        asio::ip::resolver_base::flags flags =
+            asio::ip::resolver_base::flags());
+    /** resolve a host and service without blocking
+    @details the handler is called immediately on a cache hit, otherwise from
+    a thread running the io_context of the request that started the
+    resolution*/
+    void asyncResolve(
+        asio::io_context& io_context,
+        const asio::ip::tcp& protocol,
+        const std::string& host,
+        const std::string& service,
+        ResolveHandler handler,
+        asio::ip::resolver_base::flags flags =
+            asio::ip::resolver_base::flags());
+
+    /** set how long a successful resolution is used, 0 disables caching*/
+    void setTimeToLive(std::chrono::milliseconds ttl) { timeToLive = ttl; }
+    std::chrono::milliseconds getTimeToLive() const { return timeToLive; }
+    /** set how long a failed resolution is reported without retrying, 0
+     * disables negative caching*/
+    void setNegativeTimeToLive(std::chrono::milliseconds ttl)
+    {
+        negativeTimeToLive = ttl;
+    }
+    std::chrono::milliseconds getNegativeTimeToLive() const
+    {
+        return negativeTimeToLive;
+    }
+    /** drop the cached resolutions of a host*/
+    void remove(const std::string& host);
+    /** drop all the cached resolutions*/
+    void clear();
+    /** get the number of cached resolutions including failures*/
+    std::size_t size() const;
+    /** get the number of resolutions that went to the system resolver*/
+    std::uint64_t resolutionCount() const { return resolutions.load(); }
+
+  private:
+    ResolutionCache() = default;
+
+    struct Entry {
+        std::string host;
+        std::error_code error;
+        results_type results;
+        std::chrono::steady_clock::time_point expiration;
+        bool pending{false};  //!< an asynchronous resolution is running
+        std::vector<ResolveHandler> waiting;
+    };
+    static std::string makeKey(
+        const asio::ip::tcp& protocol,
+        const std::string& host,
+        const std::string& service,
+        asio::ip::resolver_base::flags flags);
+    /** look up a current entry, must be called with the lock held*/
+    bool lookup(
+        const std::string& key,
+        std::error_code& ec,
+        results_type& results) const;
+    /** record a resolution and take the handlers waiting on it*/
+    std::vector<ResolveHandler> store(
+        const std::string& key,
+        const std::string& host,
+        const std::error_code& ec,
+        const results_type& results);
+
+    std::atomic<std::chrono::milliseconds> timeToLive{defaultTimeToLive};
+    std::atomic<std::chrono::milliseconds> negativeTimeToLive{
+        defaultNegativeTimeToLive};
+    std::atomic<std::uint64_t> resolutions{0};
+    mutable std::mutex lock;  //!< protects entries
+    std::unordered_map<std::string, Entry> entries;
+};
+}  // namespace gmlc::networking
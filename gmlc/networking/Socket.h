@@ -6,22 +6,130 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 */
 #pragma once
 
+#include "ResolutionCache.h"
+#include "TcpConnector.h"
+#include "ZeroCopyTracker.hpp"
+
+#include <asio/any_io_executor.hpp>
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
+#include <asio/post.hpp>
+#include <asio/strand.hpp>
+#include <asio/write.hpp>
 
 #ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+#include "KernelTls.hpp"
+#include "SslSessionStore.hpp"
+
 #include <asio/ssl.hpp>
 #endif
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <string>
 #include <system_error>
+#include <type_traits>
 #include <vector>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/types.h>
+#endif
+
 #include <iostream>
 
 namespace gmlc::networking {
+/** a block of memory reused for the asynchronous operation of a persistent
+handler so repeated operations do not allocate
+@details requests that do not fit, or that arrive while the block is in use,
+fall back to the global allocator*/
+class HandlerMemory {
+  public:
+    HandlerMemory() = default;
+    HandlerMemory(const HandlerMemory&) = delete;
+    HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+    void* allocate(std::size_t size)
+    {
+        if (!inUse && size <= sizeof(storage)) {
+            inUse = true;
+            return &storage;
+        }
+        return ::operator new(size);
+    }
+    void deallocate(void* pointer)
+    {
+        if (pointer == &storage) {
+            inUse = false;
+        } else {
+            ::operator delete(pointer);
+        }
+    }
+
+  private:
+    alignas(std::max_align_t) unsigned char storage[1024];
+    bool inUse{false};
+};
+
+/** allocator associated with a handler to use its HandlerMemory*/
+template<typename T>
+class HandlerAllocator {
+  public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& mem) : memory(&mem) {}
+    template<typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept :
+        memory(other.memory)
+    {
+    }
+
+    T* allocate(std::size_t count) const
+    {
+        return static_cast<T*>(memory->allocate(sizeof(T) * count));
+    }
+    void deallocate(T* pointer, std::size_t /*count*/) const
+    {
+        memory->deallocate(pointer);
+    }
+    bool operator==(const HandlerAllocator& other) const noexcept
+    {
+        return memory == other.memory;
+    }
+    bool operator!=(const HandlerAllocator& other) const noexcept
+    {
+        return memory != other.memory;
+    }
+
+  private:
+    template<typename>
+    friend class HandlerAllocator;
+    HandlerMemory* memory;
+};
+
+/** interface for a read completion handler that is reused for every read
+@details the object must stay alive until the read completes*/
+class ReadHandler {
+  public:
+    /** called when the read completes, with error code and size of data
+     * read*/
+    virtual void on_read(const std::error_code& ec, std::size_t len) = 0;
+    /** get the memory used for the asynchronous operation*/
+    HandlerMemory& handler_memory() { return memory; }
+
+  protected:
+    ~ReadHandler() = default;
+
+  private:
+    HandlerMemory memory;
+};
+
 // abstract Socket class defining what functions are needed for the rest of the
 // gmlc::networking library
 class Socket : std::enable_shared_from_this<Socket> {
@@ -33,6 +141,15 @@ class Socket : std::enable_shared_from_this<Socket> {
      */
     virtual std::size_t write_some(const void* data, std::size_t len) = 0;
 
+    /** blocking function call to write a header and a body to the socket in
+     * a single gathered write
+     *
+     * @param buffers the header and the body, either can be empty
+     * @return the number of bytes written, which can be less than the total
+     */
+    virtual std::size_t
+        write_some(const std::array<asio::const_buffer, 2>& buffers) = 0;
+
     /** blocking function call to read data from the socket
      *
      * @param data buffer to fill with read data
@@ -52,6 +169,90 @@ class Socket : std::enable_shared_from_this<Socket> {
         std::size_t len,
         std::function<void(const std::error_code&, std::size_t)> cb) = 0;
 
+    /** write as much data as possible without blocking
+     *
+     * @param data buffer of data to write
+     * @param len size of the data to write
+     * @param ec set to asio::error::would_block if nothing could be written
+     * immediately, or to the error that occurred
+     * @return the number of bytes written
+     */
+    virtual std::size_t
+        try_write_some(const void* data, std::size_t len, std::error_code& ec)
+    {
+        (void)data;
+        (void)len;
+        ec = asio::error::would_block;
+        return 0;
+    }
+
+    /** read any data already available without blocking
+     *
+     * @param data buffer to fill with read data
+     * @param len size of the buffer
+     * @param ec set to asio::error::would_block if no data is available, or to
+     * the error that occurred
+     * @return the number of bytes read
+     */
+    virtual std::size_t
+        try_read_some(void* data, std::size_t len, std::error_code& ec)
+    {
+        (void)data;
+        (void)len;
+        ec = asio::error::would_block;
+        return 0;
+    }
+
+    /** asynchronous function call to write all of a sequence of buffers to
+     * the socket
+     *
+     * @param buffers the buffers to write, the data they point to must remain
+     * valid until the callback is called
+     * @param cb function to call when all the data is written or an error
+     * occurs, with error code and amount of data written
+     */
+    virtual void async_write(
+        const std::vector<asio::const_buffer>& buffers,
+        std::function<void(const std::error_code&, std::size_t)> cb) = 0;
+
+    /** enable zero copy transmission for async_write_zero_copy
+     *
+     * @details only supported for unencrypted sockets on linux, the socket
+     * must be open
+     * @return true if zero copy transmission is available
+     */
+    virtual bool enable_zero_copy() { return false; }
+
+    /** asynchronous function call to write a buffer to the socket without
+     * copying it into the kernel
+     *
+     * @details the socket must be kept alive until the release callback is
+     * called.  If zero copy transmission is not enabled the data is written
+     * normally and released once the write completes.
+     * @param data buffer of data to write, which must not be modified or freed
+     * until the release callback is called
+     * @param len size of the data to write
+     * @param cb function to call when all the data is written or an error
+     * occurs, with error code and amount of data written
+     * @param release function to call once the buffer is no longer used
+     */
+    virtual void async_write_zero_copy(
+        const void* data,
+        std::size_t len,
+        std::function<void(const std::error_code&, std::size_t)> cb,
+        std::function<void()> release)
+    {
+        async_write(
+            {asio::const_buffer(data, len)},
+            [cb = std::move(cb), release = std::move(release)](
+                const std::error_code& ec, std::size_t bytes) {
+                cb(ec, bytes);
+                if (release) {
+                    release();
+                }
+            });
+    }
+
     /** asynchronous function call to read data from the socket
      *
      * @param data buffer to fill with read data
@@ -76,6 +277,25 @@ class Socket : std::enable_shared_from_this<Socket> {
         std::size_t len,
         std::function<void(const std::error_code&, std::size_t)> cb) = 0;
 
+    /** asynchronous function call to read data from the socket using a
+     * persistent handler
+     *
+     * @param data buffer to fill with read data
+     * @param len size of the buffer
+     * @param handler object notified when data is read, it must remain valid
+     * until then
+     */
+    virtual void
+        async_read_some(void* data, std::size_t len, ReadHandler& handler)
+    {
+        async_read_some(
+            data,
+            len,
+            [&handler](const std::error_code& ec, std::size_t bytes) {
+                handler.on_read(ec, bytes);
+            });
+    }
+
     /** asynchronous function call to establish a connection
      *
      * @param h host to connect to
@@ -90,6 +310,27 @@ class Socket : std::enable_shared_from_this<Socket> {
 
     /** perform any handshake step needed to establish a connection*/
     virtual void handshake() = 0;
+    /** perform any handshake step needed to establish a connection without
+     * blocking
+     *
+     * @param cb function called when the handshake has finished, called
+     * immediately if the protocol has no handshake
+     */
+    virtual void
+        async_handshake(std::function<void(const std::error_code&)> cb) = 0;
+    /** check if the handshake resumed a previous session instead of doing a
+     * full key exchange
+     *
+     * @return true if a session was resumed, false for a full handshake or an
+     * unencrypted socket
+     */
+    virtual bool session_resumed() const { return false; }
+    /** check if the kernel encrypts the data sent on the socket
+     *
+     * @return true if sent records are encrypted by kernel TLS, otherwise
+     * false
+     */
+    virtual bool kernel_tls_active() const { return false; }
 
     // use the socket with an asio acceptor; refactor TcpAcceptor class to use a
     // wrapper around the asio acceptor would remove the dependency on Asio
@@ -103,6 +344,14 @@ class Socket : std::enable_shared_from_this<Socket> {
      */
     virtual bool is_open() const = 0;
 
+    /** get the address of the peer of a connected socket
+     *
+     * @param ec set to what error occurred, if any
+     * @return the endpoint of the peer
+     */
+    virtual asio::ip::tcp::endpoint
+        remote_endpoint(std::error_code& ec) const = 0;
+
     /** shutdown the socket connection
      *
      * @param ec set to what error occurred, if any
@@ -117,6 +366,13 @@ class Socket : std::enable_shared_from_this<Socket> {
     /** cancel outstanding synchronous operations (connect, send, receive)*/
     virtual void cancel() = 0;
 
+    /** get the executor the completion handlers of the socket run on
+     *
+     * @details it is a strand so the handlers for one socket never run
+     * concurrently, even if several threads run the io_context
+     */
+    virtual asio::any_io_executor get_executor() = 0;
+
     /** set the TCP_NODELAY option on the socket
      *
      * @param b true if TCP_NODELAY should be enabled, otherwise false
@@ -170,24 +426,52 @@ class Socket : std::enable_shared_from_this<Socket> {
 template<class T>
 class AsioSocket final : public Socket {
   public:
-    // constructor for unencrypted Asio socket that takes an asio::io_context
+    // constructor for unencrypted Asio socket that takes an asio::io_context,
+    // the socket handlers run on a strand of the context
     AsioSocket(asio::io_context& io_context) :
-        socket_(io_context), resolver_(io_context)
+        socket_(asio::make_strand(io_context)), io_context_(io_context)
     {
     }
 #ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
     // constructor for encrypted Asio socket that takes an asio::io_context and
-    // asio::ssl::context
-    AsioSocket(asio::io_context& io_context, asio::ssl::context& ssl_context) :
-        socket_(io_context, ssl_context), resolver_(io_context)
+    // asio::ssl::context, client connections resume sessions from the store
+    AsioSocket(
+        asio::io_context& io_context,
+        asio::ssl::context& ssl_context,
+        std::shared_ptr<SslSessionStore> sessions = nullptr) :
+        socket_(asio::make_strand(io_context), ssl_context),
+        io_context_(io_context), sessions_(std::move(sessions))
+    {
+    }
+#endif
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+    // capture what is needed to move the encryption of sent records into the
+    // kernel after the handshake, the ssl context must have tracking enabled
+    void prepare_kernel_tls()
     {
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            KernelTls::track(socket_.native_handle());
+            kernel_tls_requested_ = true;
+        }
     }
 #endif
 
+    bool kernel_tls_active() const { return kernel_tls_; }
+
     // handle reads and writes by calling the corresponding asio function
     std::size_t write_some(const void* data, std::size_t len)
     {
-        return socket_.write_some(asio::buffer(data, len));
+        return with_write_stream([&](auto& stream) {
+            return stream.write_some(asio::buffer(data, len));
+        });
+    }
+    std::size_t write_some(const std::array<asio::const_buffer, 2>& buffers)
+    {
+        return with_write_stream(
+            [&](auto& stream) { return stream.write_some(buffers); });
     }
     std::size_t read_some(void* data, std::size_t len)
     {
@@ -199,7 +483,104 @@ class AsioSocket final : public Socket {
         std::size_t len,
         std::function<void(const std::error_code&, std::size_t)> cb)
     {
-        socket_.async_write_some(asio::buffer(data, len), cb);
+        with_write_stream([&](auto& stream) {
+            stream.async_write_some(asio::buffer(data, len), cb);
+        });
+    }
+
+    // only plain sockets on posix systems can write directly, the SSL stream
+    // state cannot be advanced outside of asio
+    std::size_t
+        try_write_some(const void* data, std::size_t len, std::error_code& ec)
+    {
+#ifndef _WIN32
+        if constexpr (std::is_same<T, asio::ip::tcp::socket>::value) {
+            return direct_send(socket_.native_handle(), data, len, ec);
+        }
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            // records sent with kernel TLS are written like plain data
+            if (kernel_tls_) {
+                return direct_send(
+                    socket_.lowest_layer().native_handle(), data, len, ec);
+            }
+        }
+#endif
+#endif
+        return Socket::try_write_some(data, len, ec);
+    }
+
+    std::size_t try_read_some(void* data, std::size_t len, std::error_code& ec)
+    {
+#ifndef _WIN32
+        if constexpr (std::is_same<T, asio::ip::tcp::socket>::value) {
+            if (len == 0) {
+                ec = asio::error::would_block;
+                return 0;
+            }
+            auto result =
+                ::recv(socket_.native_handle(), data, len, MSG_DONTWAIT);
+            if (result > 0) {
+                ec.clear();
+                return static_cast<std::size_t>(result);
+            }
+            ec = (result == 0) ? std::error_code(asio::error::eof) :
+                                 last_socket_error();
+            return 0;
+        }
+#endif
+        return Socket::try_read_some(data, len, ec);
+    }
+
+    void async_write(
+        const std::vector<asio::const_buffer>& buffers,
+        std::function<void(const std::error_code&, std::size_t)> cb)
+    {
+        with_write_stream(
+            [&](auto& stream) { asio::async_write(stream, buffers, cb); });
+    }
+
+    bool enable_zero_copy()
+    {
+#ifdef __linux__
+        if constexpr (std::is_same<T, asio::ip::tcp::socket>::value) {
+            if (!zeroCopy) {
+                if (ZeroCopyTracker::enable(socket_.native_handle())) {
+                    return false;
+                }
+                zeroCopy = std::make_unique<ZeroCopyTracker>();
+            }
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    void async_write_zero_copy(
+        const void* data,
+        std::size_t len,
+        std::function<void(const std::error_code&, std::size_t)> cb,
+        std::function<void()> release)
+    {
+#ifdef __linux__
+        if constexpr (std::is_same<T, asio::ip::tcp::socket>::value) {
+            if (zeroCopy) {
+                auto key = zeroCopy->beginBuffer(std::move(release));
+                zero_copy_send(
+                    static_cast<const char*>(data),
+                    len,
+                    0,
+                    ZeroCopyTracker::sendFlag,
+                    key,
+                    std::move(cb));
+                return;
+            }
+        }
+#endif
+        Socket::async_write_zero_copy(
+            data, len, std::move(cb), std::move(release));
     }
 
     void async_read_some(
@@ -216,18 +597,83 @@ class AsioSocket final : public Socket {
     {
         socket_.async_read_some(asio::buffer(data, max_sz), cb);
     }
+    // the bound handler is a single pointer and its operation memory comes
+    // from the handler so the read does not allocate
+    void async_read_some(void* data, std::size_t len, ReadHandler& handler)
+    {
+        socket_.async_read_some(
+            asio::buffer(data, len), BoundReadHandler{&handler});
+    }
 
-    // resolve the host to connect to, then use the async_connect asio function
+    // resolve the host to connect to through the shared resolution cache,
+    // then race connections to the resolved addresses
     void async_connect(
         std::string host,
         std::string service,
         std::function<void(const std::error_code&)> cb)
     {
-        // asio::ip::tcp::resolver::query query(
-        //    asio::ip::tcp::v4(), host, service);
-        auto results = resolver_.resolve(asio::ip::tcp::v4(), host, service);
-
-        socket_.lowest_layer().async_connect(*results.begin(), cb);
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            if (sessions_) {
+                sessions_->attach(
+                    socket_.native_handle(), host + ':' + service);
+            }
+        }
+#endif
+        connect_cancelled_ = false;
+        auto executor = socket_.lowest_layer().get_executor();
+        // the attempts share the strand so the connected socket keeps it
+        auto connector = TcpConnector::create(executor);
+        {
+            std::lock_guard<std::mutex> lock(connector_lock_);
+            connector_ = connector;
+        }
+        // the callback owns the socket until the connect completes
+        ResolutionCache::instance()->asyncResolve(
+            io_context_,
+            asio::ip::tcp::v4(),
+            host,
+            service,
+            [this, executor, connector, cb = std::move(cb)](
+                const std::error_code& ec,
+                const ResolutionCache::results_type& results) {
+                // a resolution shared with other sockets may complete on
+                // another context so the connect continues on the strand
+                asio::post(
+                    executor,
+                    [this,
+                     connector,
+                     cb,
+                     ec,
+                     endpoints = std::vector<asio::ip::tcp::endpoint>(
+                         results.begin(), results.end())]() mutable {
+                        if (!ec && connect_cancelled_.load()) {
+                            ec = asio::error::operation_aborted;
+                        }
+                        if (!ec && endpoints.empty()) {
+                            ec = asio::error::host_not_found;
+                        }
+                        if (ec) {
+                            cb(ec);
+                            return;
+                        }
+                        connector->asyncConnect(
+                            endpoints,
+                            [this, cb](
+                                std::error_code error,
+                                asio::ip::tcp::socket connected) {
+                                if (!error && connect_cancelled_.load()) {
+                                    error = asio::error::operation_aborted;
+                                }
+                                if (!error) {
+                                    use_connected(std::move(connected));
+                                }
+                                cb(error);
+                            });
+                    });
+            });
     }
 
     /* // potential future API addition - change SSL certificate verification
@@ -254,16 +700,57 @@ T>::value) { socket_.set_verify_callback(cb);
         if constexpr (std::is_base_of<
                           asio::ssl::stream<asio::ip::tcp::socket>,
                           T>::value) {
-            socket_.set_verify_mode(asio::ssl::verify_peer);
-            socket_.set_verify_callback(
-                [](bool preverified, asio::ssl::verify_context& /*ctx*/) {
-                    return preverified;
-                });
+            prepare_handshake();
             socket_.handshake(
                 handshake_server_ ? asio::ssl::stream_base::server :
                                     asio::ssl::stream_base::client);
+            start_kernel_tls();
+        }
+#endif
+    }
+
+    bool session_resumed() const
+    {
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            return SSL_session_reused(
+                       const_cast<T&>(socket_).native_handle()) == 1;
+        }
+#endif
+        return false;
+    }
+
+    // Perform handshake step without blocking the io thread, if protocol
+    // requires it (SSL)
+    void async_handshake(std::function<void(const std::error_code&)> cb)
+    {
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            prepare_handshake();
+            if (!kernel_tls_requested_) {
+                socket_.async_handshake(
+                    handshake_server_ ? asio::ssl::stream_base::server :
+                                        asio::ssl::stream_base::client,
+                    std::move(cb));
+                return;
+            }
+            socket_.async_handshake(
+                handshake_server_ ? asio::ssl::stream_base::server :
+                                    asio::ssl::stream_base::client,
+                [this, cb = std::move(cb)](const std::error_code& ec) {
+                    if (!ec) {
+                        start_kernel_tls();
+                    }
+                    cb(ec);
+                });
+            return;
         }
 #endif
+        cb(std::error_code());
     }
 
     // sets up an asio acceptor to use this socket
@@ -277,6 +764,12 @@ T>::value) { socket_.set_verify_callback(cb);
     // check if the underlying asio socket connection is open
     bool is_open() const { return socket_.lowest_layer().is_open(); }
 
+    // get the address of the peer the socket is connected to
+    asio::ip::tcp::endpoint remote_endpoint(std::error_code& ec) const
+    {
+        return socket_.lowest_layer().remote_endpoint(ec);
+    }
+
     // call the underlying asio functions to shutdown a connected socket
     std::error_code shutdown(std::error_code& ec)
     {
@@ -288,12 +781,24 @@ T>::value) { socket_.set_verify_callback(cb);
     // preferred)
     std::error_code close(std::error_code& ec)
     {
+        connect_cancelled_ = true;
+        cancel_connect();
         return socket_.lowest_layer().close(ec);
     }
 
     // cancel outstanding asynchronous operations (connect, send, receive)
     // immediately
-    void cancel() { socket_.lowest_layer().cancel(); }
+    void cancel()
+    {
+        connect_cancelled_ = true;
+        cancel_connect();
+        socket_.lowest_layer().cancel();
+    }
+
+    asio::any_io_executor get_executor()
+    {
+        return socket_.lowest_layer().get_executor();
+    }
 
     // set_option templated functions are the same as the definitions in asio
     template<typename SettableSocketOption>
@@ -325,7 +830,191 @@ T>::value) { socket_.set_verify_callback(cb);
     }
 
   private:
+    // stop a connect in progress, close and cancel can be called from any
+    // thread while the connect runs on the strand
+    void cancel_connect()
+    {
+        std::shared_ptr<TcpConnector> connector;
+        {
+            std::lock_guard<std::mutex> lock(connector_lock_);
+            connector = connector_;
+        }
+        if (connector) {
+            connector->cancel();
+        }
+    }
+    // take over the socket the connector connected, an encrypted stream
+    // wraps it as its next layer
+    void use_connected(asio::ip::tcp::socket connected)
+    {
+        if constexpr (std::is_same<T, asio::ip::tcp::socket>::value) {
+            socket_ = std::move(connected);
+        } else {
+            socket_.next_layer() = std::move(connected);
+        }
+    }
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+    // set the peer verification used by the handshake
+    void prepare_handshake()
+    {
+        socket_.set_verify_mode(asio::ssl::verify_peer);
+        socket_.set_verify_callback(
+            [](bool preverified, asio::ssl::verify_context& /*ctx*/) {
+                return preverified;
+            });
+    }
+    // hand the encryption of sent records to the kernel after a completed
+    // handshake, the connection keeps using OpenSSL if that is not possible
+    void start_kernel_tls()
+    {
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            if (kernel_tls_requested_) {
+                kernel_tls_ = !KernelTls::enableTransmit(
+                    socket_.native_handle(),
+                    socket_.lowest_layer().native_handle());
+            }
+        }
+    }
+#endif
+    // run a write operation on the stream that sends encrypted records, which
+    // is the tcp socket itself once the kernel encrypts them
+    template<class Operation>
+    decltype(auto) with_write_stream(Operation&& operation)
+    {
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+        if constexpr (std::is_base_of<
+                          asio::ssl::stream<asio::ip::tcp::socket>,
+                          T>::value) {
+            if (kernel_tls_) {
+                return operation(socket_.next_layer());
+            }
+        }
+#endif
+        return operation(socket_);
+    }
+#ifndef _WIN32
+    // write as much as possible directly to a socket without blocking
+    static std::size_t direct_send(
+        int descriptor,
+        const void* data,
+        std::size_t len,
+        std::error_code& ec)
+    {
+#ifdef MSG_NOSIGNAL
+        constexpr int flags{MSG_DONTWAIT | MSG_NOSIGNAL};
+#else
+        constexpr int flags{MSG_DONTWAIT};
+#endif
+        auto result = ::send(descriptor, data, len, flags);
+        if (result >= 0) {
+            ec.clear();
+            return static_cast<std::size_t>(result);
+        }
+        ec = last_socket_error();
+        return 0;
+    }
+#endif
+#ifndef _WIN32
+    // translate errno from a direct socket call
+    static std::error_code last_socket_error()
+    {
+        const int err = errno;
+        if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR) {
+            return asio::error::would_block;
+        }
+        return {err, std::system_category()};
+    }
+#endif
+
+    struct BoundReadHandler {
+        using allocator_type = HandlerAllocator<char>;
+
+        ReadHandler* handler;
+        void operator()(const std::error_code& ec, std::size_t bytes) const
+        {
+            handler->on_read(ec, bytes);
+        }
+        allocator_type get_allocator() const noexcept
+        {
+            return allocator_type(handler->handler_memory());
+        }
+    };
+
+    // send the remainder of a zero copy buffer, each send call that used the
+    // zero copy flag is recorded so the kernel notifications can be matched
+    void zero_copy_send(
+        const char* data,
+        std::size_t len,
+        std::size_t sent,
+        int flags,
+        std::uint64_t key,
+        std::function<void(const std::error_code&, std::size_t)> cb)
+    {
+        socket_.async_send(
+            asio::buffer(data + sent, len - sent),
+            flags,
+            [this, data, len, sent, flags, key, cb = std::move(cb)](
+                const std::error_code& ec, std::size_t bytes) mutable {
+                if (ec == std::errc::no_buffer_space && flags != 0) {
+                    // the kernel could not pin the pages so copy the rest
+                    zero_copy_send(data, len, sent, 0, key, std::move(cb));
+                    return;
+                }
+                if (!ec && bytes > 0 && flags != 0) {
+                    zeroCopy->recordSend(key);
+                }
+                sent += bytes;
+                if (!ec && sent < len) {
+                    zero_copy_send(data, len, sent, flags, key, std::move(cb));
+                    return;
+                }
+                auto release = zeroCopy->endBuffer(key);
+                wait_zero_copy_completions();
+                cb(ec, sent);
+                if (release) {
+                    release();
+                }
+            });
+    }
+
+    // completions are reported through the socket error queue, a wait is
+    // kept active as long as there are unreleased buffers
+    void wait_zero_copy_completions()
+    {
+        if (!zeroCopy->startWait()) {
+            return;
+        }
+        socket_.async_wait(
+            asio::socket_base::wait_error, [this](const std::error_code& ec) {
+                auto released = (ec) ?
+                    zeroCopy->releaseAll() :
+                    zeroCopy->readCompletions(socket_.native_handle());
+                if (!ec) {
+                    wait_zero_copy_completions();
+                }
+                // a release can drop the last reference to the socket so
+                // nothing may touch this afterwards
+                for (const auto& release : released) {
+                    if (release) {
+                        release();
+                    }
+                }
+            });
+    }
+
     T socket_;
-    asio::ip::tcp::resolver resolver_;
+    asio::io_context& io_context_;
+    std::mutex connector_lock_;  // protects connector_
+    std::shared_ptr<TcpConnector> connector_;
+    // closed or cancelled while the host was being resolved or connected
+    std::atomic<bool> connect_cancelled_{false};
+    std::unique_ptr<ZeroCopyTracker> zeroCopy;
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+    std::shared_ptr<SslSessionStore> sessions_;
+    bool kernel_tls_requested_{false};
+#endif
+    bool kernel_tls_{false};  // sent records are encrypted by the kernel
 };
 }  // namespace gmlc::networking
@@ -7,6 +7,7 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include "SocketFactory.h"
 
+#include <algorithm>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <sstream>
@@ -43,6 +44,142 @@ void SocketFactory::parse_json_config(std::string conf_str)
     rsa_private_key_file =
         j.value("rsa_private_key_file", rsa_private_key_file);
     tmp_dh_file = j.value("tmp_dh_file", tmp_dh_file);
+    session_resumption = j.value("session_resumption", session_resumption);
+    session_tickets = j.value("session_tickets", session_tickets);
+    session_cache_size = j.value("session_cache_size", session_cache_size);
+    session_timeout = j.value("session_timeout", session_timeout);
+    kernel_tls = j.value("kernel_tls", kernel_tls);
+    // the settings may have changed so copies made earlier keep their context
+    // and this factory builds a new one when it is next needed
+    ssl_cache = std::make_shared<SslContextCache>();
 #endif
 }
+
+std::string SocketFactory::get_settings_key() const
+{
+    json j;
+    j["encrypted"] = encrypted;
+    j["handshake_server"] = handshake_server;
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+    if (encrypted) {
+        j["use_default_verify_paths"] = use_default_verify_paths;
+        j["verify_file"] = verify_file;
+        j["verify_path"] = verify_path;
+        j["certificate_chain_file"] = certificate_chain_file;
+        j["certificate_file"] = certificate_file;
+        j["private_key_file"] = private_key_file;
+        j["rsa_private_key_file"] = rsa_private_key_file;
+        j["tmp_dh_file"] = tmp_dh_file;
+        j["session_resumption"] = session_resumption;
+        j["session_tickets"] = session_tickets;
+        j["session_cache_size"] = session_cache_size;
+        j["session_timeout"] = session_timeout;
+        j["kernel_tls"] = kernel_tls;
+    }
+#endif
+    return j.dump();
+}
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+std::shared_ptr<asio::ssl::context> SocketFactory::get_ssl_context() const
+{
+    std::lock_guard<std::mutex> lock(ssl_cache->lock);
+    if (!ssl_cache->context) {
+        ssl_cache->context = build_ssl_context();
+    }
+    return ssl_cache->context;
+}
+
+std::shared_ptr<SslSessionStore> SocketFactory::get_session_store() const
+{
+    if (!session_resumption) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(ssl_cache->lock);
+    if (!ssl_cache->sessions) {
+        ssl_cache->sessions = SslSessionStore::create(
+            static_cast<size_t>((std::max)(session_cache_size, 1)));
+    }
+    return ssl_cache->sessions;
+}
+
+void SocketFactory::reload_ssl_context()
+{
+    auto context = build_ssl_context();
+    std::lock_guard<std::mutex> lock(ssl_cache->lock);
+    ssl_cache->context = std::move(context);
+}
+
+std::shared_ptr<asio::ssl::context> SocketFactory::build_ssl_context() const
+{
+    // SSL_CTX should not be changed after using it to create any SSL objects
+    // more details at:
+    // https://www.openssl.org/docs/manmaster/man3/SSL_CTX_new.html
+    auto ssl_context =
+        std::make_shared<asio::ssl::context>(asio::ssl::context::tls);
+
+    if (!password.empty()) {
+        ssl_context->set_password_callback(
+            [pw = this->password](auto /*max_len*/, auto /*purpose*/) {
+                return pw;
+            });
+    }
+    if (use_default_verify_paths) {
+        ssl_context->set_default_verify_paths();
+    }
+    if (!verify_file.empty()) {
+        ssl_context->load_verify_file(verify_file);
+    }
+    if (!verify_path.empty()) {
+        ssl_context->add_verify_path(verify_path);
+    }
+    if (!certificate_chain_file.empty()) {
+        ssl_context->use_certificate_chain_file(certificate_chain_file);
+    }
+    if (!certificate_file.empty()) {
+        ssl_context->use_certificate_file(
+            certificate_file, asio::ssl::context::pem);
+    }
+    if (!private_key_file.empty()) {
+        ssl_context->use_private_key_file(
+            private_key_file, asio::ssl::context::pem);
+    }
+    if (!rsa_private_key_file.empty()) {
+        ssl_context->use_rsa_private_key_file(
+            rsa_private_key_file, asio::ssl::context::pem);
+    }
+    if (!tmp_dh_file.empty()) {
+        ssl_context->use_tmp_dh_file(tmp_dh_file);
+    }
+
+    auto* handle = ssl_context->native_handle();
+    if (session_resumption) {
+        // servers keep sessions in the OpenSSL cache, clients report theirs
+        // to the session store of the factory
+        SSL_CTX_set_session_cache_mode(handle, SSL_SESS_CACHE_SERVER);
+        SslSessionStore::enableClientSessions(handle);
+        // sessions are only resumed within the same id context, which is
+        // required when peers are verified
+        static constexpr unsigned char sessionContext[] = "gmlc_networking";
+        SSL_CTX_set_session_id_context(
+            handle, sessionContext, sizeof(sessionContext) - 1);
+        if (session_cache_size > 0) {
+            SSL_CTX_sess_set_cache_size(handle, session_cache_size);
+        }
+        if (session_timeout > 0) {
+            SSL_CTX_set_timeout(handle, session_timeout);
+        }
+        if (!session_tickets) {
+            SSL_CTX_set_options(handle, SSL_OP_NO_TICKET);
+        }
+    } else {
+        SSL_CTX_set_session_cache_mode(handle, SSL_SESS_CACHE_OFF);
+        SSL_CTX_set_options(handle, SSL_OP_NO_TICKET);
+    }
+    if (kernel_tls) {
+        KernelTls::enableTracking(handle);
+    }
+    return ssl_context;
+}
+#endif
 }  // namespace gmlc::networking
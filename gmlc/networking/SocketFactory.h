@@ -16,6 +16,7 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <system_error>
@@ -57,49 +58,15 @@ class SocketFactory : std::enable_shared_from_this<SocketFactory> {
                 io_context);
         } else {
 #ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
-            // SSL_CTX in OpenSSL is reference counted; asio::ssl::context is a
-            // wrapper around a SSL_CTX* SSL_CTX should not be changed after
-            // using it to create any SSL objects more details at:
-            // https://www.openssl.org/docs/manmaster/man3/SSL_CTX_new.html
-            asio::ssl::context ssl_context(asio::ssl::context::tls);
-
-            if (!password.empty()) {
-                ssl_context.set_password_callback(
-                    [pw = this->password](auto /*max_len*/, auto /*purpose*/) {
-                        return pw;
-                    });
-            }
-            if (use_default_verify_paths) {
-                ssl_context.set_default_verify_paths();
-            }
-            if (!verify_file.empty()) {
-                ssl_context.load_verify_file(verify_file);
-            }
-            if (!verify_path.empty()) {
-                ssl_context.add_verify_path(verify_path);
-            }
-            if (!certificate_chain_file.empty()) {
-                ssl_context.use_certificate_chain_file(certificate_chain_file);
-            }
-            if (!certificate_file.empty()) {
-                ssl_context.use_certificate_file(
-                    certificate_file, asio::ssl::context::pem);
-            }
-            if (!private_key_file.empty()) {
-                ssl_context.use_private_key_file(
-                    private_key_file, asio::ssl::context::pem);
-            }
-            if (!rsa_private_key_file.empty()) {
-                ssl_context.use_rsa_private_key_file(
-                    rsa_private_key_file, asio::ssl::context::pem);
-            }
-            if (!tmp_dh_file.empty()) {
-                ssl_context.use_tmp_dh_file(tmp_dh_file);
-            }
-
-            return std::make_shared<
+            // SSL_CTX in OpenSSL is reference counted so each socket keeps the
+            // context it was created with even if the context is reloaded
+            auto socket = std::make_shared<
                 AsioSocket<asio::ssl::stream<asio::ip::tcp::socket>>>(
-                io_context, ssl_context);
+                io_context, *get_ssl_context(), get_session_store());
+            if (kernel_tls) {
+                socket->prepare_kernel_tls();
+            }
+            return socket;
 #else
             throw std::runtime_error(
                 "gmlc::networking library not compiled with encryption support");
@@ -130,6 +97,46 @@ class SocketFactory : std::enable_shared_from_this<SocketFactory> {
      */
     void set_encrypted(bool b) { encrypted = b; }
 
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+    /** get the ssl context used by encrypted sockets
+     *
+     * the context is built from the settings on first use and shared by all
+     * sockets created by this factory and its copies, so the certificate and
+     * key files are only read once
+     *
+     * @return the shared ssl context
+     * @throws std::system_error thrown if a file cannot be loaded
+     */
+    std::shared_ptr<asio::ssl::context> get_ssl_context() const;
+
+    /** rebuild the ssl context by reading the certificate and key files again
+     *
+     * sockets created afterwards use the new context, existing connections
+     * keep the one they were created with
+     *
+     * @throws std::system_error thrown if a file cannot be loaded, the
+     * previous context is kept in that case
+     */
+    void reload_ssl_context();
+
+    /** get the store of the TLS sessions of client connections
+     *
+     * @return the store shared by the sockets of this factory, or nullptr if
+     * session resumption is disabled
+     */
+    std::shared_ptr<SslSessionStore> get_session_store() const;
+#endif
+
+    /** get a string identifying the settings of the sockets this factory
+     * creates
+     *
+     * factories with equal keys create interchangeable sockets, the password
+     * is not part of the key
+     *
+     * @return the settings as a JSON string
+     */
+    std::string get_settings_key() const;
+
     /** load settings into the SocketFactory from a JSON config file
      *
      * @param file the JSON file to load settings from
@@ -168,6 +175,24 @@ class SocketFactory : std::enable_shared_from_this<SocketFactory> {
                               // SSL
     std::string password;  // used in the password response callback when
                            // loading SSL certificate/key files
+    bool session_resumption{true};  // resume previous sessions on reconnect
+    bool session_tickets{true};  // allow stateless session tickets
+    int session_cache_size{1024};  // sessions kept by servers and clients
+    int session_timeout{300};  // seconds a session can be resumed for
+    bool kernel_tls{false};  // try to have the kernel encrypt sent records
+
+    // the ssl context built from the settings, shared between copies of the
+    // factory made with the same settings
+    struct SslContextCache {
+        std::mutex lock;
+        std::shared_ptr<asio::ssl::context> context;
+        std::shared_ptr<SslSessionStore> sessions;
+    };
+    std::shared_ptr<SslContextCache> ssl_cache{
+        std::make_shared<SslContextCache>()};
+
+    // create an ssl context from the current settings
+    std::shared_ptr<asio::ssl::context> build_ssl_context() const;
 #endif
 };
 }  // namespace gmlc::networking
@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "SslSessionStore.hpp"
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+#include <utility>
+
+namespace gmlc::networking {
+namespace {
+    /// the store and key a client connection reports its sessions to
+    struct SessionTarget {
+        std::weak_ptr<SslSessionStore> store;
+        std::string key;
+    };
+
+    void freeSessionTarget(
+        void* /*parent*/,
+        void* ptr,
+        CRYPTO_EX_DATA* /*ad*/,
+        int /*idx*/,
+        long /*argl*/,  // NOLINT
+        void* /*argp*/)
+    {
+        delete static_cast<SessionTarget*>(ptr);
+    }
+
+    int sessionTargetIndex()
+    {
+        static const int index = SSL_get_ex_new_index(
+            0, nullptr, nullptr, nullptr, freeSessionTarget);
+        return index;
+    }
+}  // namespace
+
+std::shared_ptr<SslSessionStore> SslSessionStore::create(size_t maxSessions)
+{
+    return std::shared_ptr<SslSessionStore>(new SslSessionStore(maxSessions));
+}
+
+SslSessionStore::~SslSessionStore()
+{
+    clear();
+}
+
+void SslSessionStore::enableClientSessions(SSL_CTX* context)
+{
+    SSL_CTX_set_session_cache_mode(
+        context,
+        SSL_CTX_get_session_cache_mode(context) | SSL_SESS_CACHE_CLIENT);
+    SSL_CTX_sess_set_new_cb(context, &SslSessionStore::newSession);
+}
+
+void SslSessionStore::attach(SSL* ssl, const std::string& key)
+{
+    {
+        std::lock_guard<std::mutex> sessionLock(lock);
+        auto fnd = sessions.find(key);
+        if (fnd != sessions.end()) {
+            // the connection takes its own reference to the session
+            SSL_set_session(ssl, fnd->second);
+        }
+    }
+    auto* target = new SessionTarget{weak_from_this(), key};
+    if (SSL_set_ex_data(ssl, sessionTargetIndex(), target) != 1) {
+        delete target;
+    }
+}
+
+int SslSessionStore::newSession(SSL* ssl, SSL_SESSION* session)
+{
+    auto* target =
+        static_cast<SessionTarget*>(SSL_get_ex_data(ssl, sessionTargetIndex()));
+    if (target == nullptr) {
+        // server connections and clients without a store
+        return 0;
+    }
+    auto store = target->store.lock();
+    if (!store) {
+        return 0;
+    }
+    store->store(target->key, session);
+    return 1;
+}
+
+void SslSessionStore::store(const std::string& key, SSL_SESSION* session)
+{
+    SSL_SESSION* previous{nullptr};
+    {
+        std::lock_guard<std::mutex> sessionLock(lock);
+        auto fnd = sessions.find(key);
+        if (fnd != sessions.end()) {
+            previous = fnd->second;
+            fnd->second = session;
+        } else {
+            if (sessions.size() >= maxSize && !sessions.empty()) {
+                previous = sessions.begin()->second;
+                sessions.erase(sessions.begin());
+            }
+            sessions.emplace(key, session);
+        }
+    }
+    if (previous != nullptr) {
+        SSL_SESSION_free(previous);
+    }
+}
+
+void SslSessionStore::remove(const std::string& key)
+{
+    SSL_SESSION* session{nullptr};
+    {
+        std::lock_guard<std::mutex> sessionLock(lock);
+        auto fnd = sessions.find(key);
+        if (fnd == sessions.end()) {
+            return;
+        }
+        session = fnd->second;
+        sessions.erase(fnd);
+    }
+    SSL_SESSION_free(session);
+}
+
+void SslSessionStore::clear()
+{
+    std::unordered_map<std::string, SSL_SESSION*> removed;
+    {
+        std::lock_guard<std::mutex> sessionLock(lock);
+        removed.swap(sessions);
+    }
+    for (auto& entry : removed) {
+        SSL_SESSION_free(entry.second);
+    }
+}
+
+size_t SslSessionStore::size() const
+{
+    std::lock_guard<std::mutex> sessionLock(lock);
+    return sessions.size();
+}
+
+}  // namespace gmlc::networking
+#endif
@@ -0,0 +1,66 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <string>
+#include <unordered_map>
+
+/** @file
+storage of TLS sessions so client connections can resume them
+*/
+namespace gmlc::networking {
+/** the TLS sessions of client connections keyed by host:port
+@details a connection to a server with a stored session offers it during the
+handshake so the server can skip the key exchange and certificate checks.
+New sessions, including TLS 1.3 tickets that arrive after the handshake, are
+stored as the server issues them.
+*/
+class SslSessionStore : public std::enable_shared_from_this<SslSessionStore> {
+  public:
+    /** create a store
+    @param maxSessions the number of sessions kept, when full an arbitrary
+    session is dropped to make room*/
+    static std::shared_ptr<SslSessionStore> create(size_t maxSessions);
+    /** releases the stored sessions*/
+    ~SslSessionStore();
+    SslSessionStore(const SslSessionStore&) = delete;
+    SslSessionStore& operator=(const SslSessionStore&) = delete;
+
+    /** set up an ssl context so the sessions of client connections created
+     * from it are reported to their store*/
+    static void enableClientSessions(SSL_CTX* context);
+    /** prepare a client connection to a server
+    @details offers the stored session for the key, if any, and stores the
+    sessions the server issues to the connection under the key*/
+    void attach(SSL* ssl, const std::string& key);
+
+    /** store a session, the store takes over the reference*/
+    void store(const std::string& key, SSL_SESSION* session);
+    /** remove the session for a key*/
+    void remove(const std::string& key);
+    /** remove all the sessions*/
+    void clear();
+    /** get the number of stored sessions*/
+    size_t size() const;
+
+  private:
+    explicit SslSessionStore(size_t maxSessions) : maxSize(maxSessions) {}
+    /** callback for sessions issued to a connection*/
+    static int newSession(SSL* ssl, SSL_SESSION* session);
+
+    const size_t maxSize;
+    mutable std::mutex lock;  //!< protects sessions
+    std::unordered_map<std::string, SSL_SESSION*> sessions;
+};
+}  // namespace gmlc::networking
+#endif
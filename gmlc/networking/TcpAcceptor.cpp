@@ -17,15 +17,49 @@ namespace gmlc::networking {
 using asio::ip::tcp;
 using namespace std::chrono_literals;  // NOLINT
 
+#ifdef SO_REUSEPORT
+namespace {
+    /** settable socket option for SO_REUSEPORT*/
+    class ReusePortOption {
+      public:
+        explicit ReusePortOption(bool reuse) : value(reuse ? 1 : 0) {}
+        template<class Protocol>
+        int level(const Protocol& /*protocol*/) const
+        {
+            return SOL_SOCKET;
+        }
+        template<class Protocol>
+        int name(const Protocol& /*protocol*/) const
+        {
+            return SO_REUSEPORT;
+        }
+        template<class Protocol>
+        const void* data(const Protocol& /*protocol*/) const
+        {
+            return &value;
+        }
+        template<class Protocol>
+        std::size_t size(const Protocol& /*protocol*/) const
+        {
+            return sizeof(value);
+        }
+
+      private:
+        int value;
+    };
+}  // namespace
+#endif
+
 TcpAcceptor::TcpAcceptor(asio::io_context& io_context, tcp::endpoint& ep) :
-    endpoint_(ep), acceptor_(io_context)
+    context_(io_context), endpoint_(ep),
+    acceptor_(asio::make_strand(io_context))
 {
     acceptor_.open(ep.protocol());
 }
 
 TcpAcceptor::TcpAcceptor(asio::io_context& io_context, uint16_t port) :
-    endpoint_(asio::ip::address_v4::any(), port),
-    acceptor_(io_context, endpoint_.protocol()),
+    context_(io_context), endpoint_(asio::ip::address_v4::any(), port),
+    acceptor_(asio::make_strand(io_context), endpoint_.protocol()),
     state(AcceptingStates::CONNECTED)
 {
 }
@@ -76,6 +110,41 @@ bool TcpAcceptor::connect(std::chrono::milliseconds timeOut)
     return (state == AcceptingStates::CONNECTED);
 }
 
+bool TcpAcceptor::set_reuse_port(bool reuse)
+{
+#ifdef SO_REUSEPORT
+    std::error_code ec;
+    acceptor_.set_option(ReusePortOption(reuse), ec);
+    if (ec) {
+        logger(1, std::string("unable to set SO_REUSEPORT ") + ec.message());
+        return false;
+    }
+    return true;
+#else
+    (void)reuse;
+    return false;
+#endif
+}
+
+bool TcpAcceptor::listen()
+{
+    if (listening.load()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(acceptLock);
+    if (listening.load()) {
+        return true;
+    }
+    std::error_code ec;
+    acceptor_.listen(listenBacklog, ec);
+    if (ec) {
+        logger(0, std::string("unable to listen ") + ec.message());
+        return false;
+    }
+    listening.store(true);
+    return true;
+}
+
 /** start the acceptor*/
 bool TcpAcceptor::start(TcpConnection::pointer conn)
 {
@@ -94,17 +163,19 @@ bool TcpAcceptor::start(TcpConnection::pointer conn)
         logger(1, "acceptor is not in a connected state");
         return false;
     }
-    if (accepting.activate()) {
-        auto socket = conn->socket();
-        acceptor_.listen();
-        auto ptr = shared_from_this();
-        socket->use_with_acceptor(
-            acceptor_,
-            [this, apointer = std::move(ptr), connection = std::move(conn)](
-                const std::error_code& error) {
-                handle_accept(apointer, connection, error);
-            });
-        return true;
+    if (!listen()) {
+        conn->close();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(acceptLock);
+        if (pendingCount < pendingAccepts) {
+            if (pendingCount++ == 0) {
+                accepting.activate();
+            }
+            asyncAccept(std::move(conn));
+            return true;
+        }
     }
 
     logger(1, "acceptor is already active");
@@ -112,11 +183,50 @@ bool TcpAcceptor::start(TcpConnection::pointer conn)
     return false;
 }
 
+bool TcpAcceptor::start()
+{
+    if (!connectionFactory) {
+        logger(0, "acceptor has no connection factory");
+        return false;
+    }
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(acceptLock);
+            if (pendingCount >= pendingAccepts) {
+                return true;
+            }
+        }
+        if (!start(connectionFactory(*this))) {
+            return isAccepting();
+        }
+    }
+}
+
+void TcpAcceptor::asyncAccept(TcpConnection::pointer conn)
+{
+    auto socket = conn->socket();
+    socket->use_with_acceptor(
+        acceptor_,
+        [this, apointer = shared_from_this(), connection = std::move(conn)](
+            const std::error_code& error) {
+            handle_accept(apointer, connection, error);
+        });
+}
+
+void TcpAcceptor::finishAccept()
+{
+    std::lock_guard<std::mutex> lock(acceptLock);
+    if (--pendingCount == 0) {
+        accepting.reset();
+    }
+}
+
 /** close the acceptor*/
 void TcpAcceptor::close()
 {
     state = AcceptingStates::HALTED;
     acceptor_.close();
+    listening.store(false);
     accepting.wait();
 }
 
@@ -136,16 +246,22 @@ void TcpAcceptor::handle_accept(
         std::error_code ec;
         new_connection->socket()->set_option_linger(true, 0, ec);
         new_connection->close();
-        accepting.reset();
+        finishAccept();
         return;
     }
     if (!error) {
         if (acceptCall) {
-            accepting.reset();
-            acceptCall(std::move(ptr), std::move(new_connection));
-            if (!accepting.isActive()) {
-                accepting.trigger();
+            TcpConnection::pointer next;
+            if (connectionFactory) {
+                next = connectionFactory(*this);
+            }
+            if (next) {
+                // replace this accept before the new connection is set up
+                asyncAccept(std::move(next));
+            } else {
+                finishAccept();
             }
+            acceptCall(std::move(ptr), std::move(new_connection));
         } else {
             try {
                 new_connection->socket()->set_option_linger(true, 0);
@@ -153,7 +269,7 @@ void TcpAcceptor::handle_accept(
             catch (...) {
             }
             new_connection->close();
-            accepting.reset();
+            finishAccept();
         }
     } else if (error != asio::error::operation_aborted) {
         if (errorCall) {
@@ -167,10 +283,10 @@ void TcpAcceptor::handle_accept(
         catch (...) {
         }
         new_connection->close();
-        accepting.reset();
+        finishAccept();
     } else {
         new_connection->close();
-        accepting.reset();
+        finishAccept();
     }
 }
 
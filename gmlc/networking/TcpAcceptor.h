@@ -11,8 +11,10 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
+#include <asio/strand.hpp>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,6 +36,8 @@ class TcpAcceptor : public std::enable_shared_from_this<TcpAcceptor> {
         CLOSED = 4,
     };
     using pointer = std::shared_ptr<TcpAcceptor>;
+    /// the number of accepts kept pending at once by default
+    static constexpr int defaultPendingAccepts{1};
     /** create an RxConnection object using the specified context and
      * bufferSize*/
     static pointer
@@ -61,8 +65,14 @@ class TcpAcceptor : public std::enable_shared_from_this<TcpAcceptor> {
     /** connect the acceptor to the socket if disconnected and try up to
      * timeout*/
     bool connect(std::chrono::milliseconds timeOut);
-    /** start the acceptor*/
+    /** start an accept into a connection
+    @return false if the connection is invalid, the acceptor is not connected,
+    or the pending accept limit is already reached*/
     bool start(TcpConnection::pointer conn);
+    /** start accepts into connections from the connection factory until the
+    pending accept limit is reached
+    @return true if any accepts are pending*/
+    bool start();
     /** cancel pending operations*/
     void cancel() { acceptor_.cancel(); }
     /** close the socket*/
@@ -82,6 +92,27 @@ class TcpAcceptor : public std::enable_shared_from_this<TcpAcceptor> {
         acceptCall = std::move(accFunc);
     }
 
+    /** set the function creating the connections accepts are made into
+    @details with a connection factory each completed accept is replaced
+    before the accept callback runs, so the next connection is accepted while
+    the previous one is set up*/
+    void setConnectionFactory(
+        std::function<TcpConnection::pointer(const TcpAcceptor&)> factory)
+    {
+        connectionFactory = std::move(factory);
+    }
+    /** set the backlog of the listen queue, must be called before start*/
+    void setListenBacklog(int backlog) { listenBacklog = backlog; }
+    /** get the backlog of the listen queue*/
+    int getListenBacklog() const { return listenBacklog; }
+    /** set the number of accepts kept pending at once, at least 1*/
+    void setPendingAccepts(int count)
+    {
+        pendingAccepts = (count > 1) ? count : 1;
+    }
+    /** get the number of accepts kept pending at once*/
+    int getPendingAccepts() const { return pendingAccepts; }
+
     /** set the error path callback*/
     void setErrorCall(
         std::function<bool(TcpAcceptor::pointer, const std::error_code&)>
@@ -99,12 +130,24 @@ class TcpAcceptor : public std::enable_shared_from_this<TcpAcceptor> {
     {
         acceptor_.set_option(option);
     }
+    /** allow several acceptors to bind the same port with SO_REUSEPORT so
+    the kernel spreads incoming connections over them
+    @return false if the platform does not support the option*/
+    bool set_reuse_port(bool reuse);
+    /** get the context the acceptor runs on*/
+    asio::io_context& getContext() const { return context_; }
     /** generate a string from the associated endpoint*/
     std::string to_string() const;
 
   private:
     TcpAcceptor(asio::io_context& io_context, asio::ip::tcp::endpoint& ep);
     TcpAcceptor(asio::io_context& io_context, uint16_t port);
+    /** start listening on the bound socket if not already listening*/
+    bool listen();
+    /** issue an asynchronous accept into a connection*/
+    void asyncAccept(TcpConnection::pointer conn);
+    /** record that a pending accept has finished*/
+    void finishAccept();
     /** function for handling the asynchronous return from a read request*/
     void handle_accept(
         TcpAcceptor::pointer ptr,
@@ -112,13 +155,22 @@ class TcpAcceptor : public std::enable_shared_from_this<TcpAcceptor> {
         const std::error_code& error);
 
     void logger(int level, const std::string& message);
+    asio::io_context& context_;
     asio::ip::tcp::endpoint endpoint_;
     asio::ip::tcp::acceptor acceptor_;
     std::function<void(TcpAcceptor::pointer, TcpConnection::pointer)>
         acceptCall;
     std::function<bool(TcpAcceptor::pointer, const std::error_code&)> errorCall;
+    std::function<TcpConnection::pointer(const TcpAcceptor&)>
+        connectionFactory;
     std::function<void(int level, const std::string& logMessage)> logFunction;
     std::atomic<AcceptingStates> state{AcceptingStates::OPENED};
+    std::atomic<bool> listening{false};
+    int listenBacklog{asio::socket_base::max_listen_connections};
+    int pendingAccepts{defaultPendingAccepts};
+    std::mutex acceptLock;  //!< protects pendingCount and accepting
+    int pendingCount{0};  //!< the number of accepts in progress
+    /// active while any accept is in progress
     gmlc::concurrency::TriggerVariable accepting;
 };
 
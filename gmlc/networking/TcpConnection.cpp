@@ -7,8 +7,13 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include "TcpConnection.h"
 
+#include "ResolutionCache.h"
+
 #include <algorithm>
+#include <asio/dispatch.hpp>
+#include <array>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -21,12 +26,24 @@ using namespace std::chrono_literals;  // NOLINT
 std::atomic<int> TcpConnection::idcounter{10};
 
 void TcpConnection::startReceive()
+{
+    pointer self;
+    continueReceive(self);
+}
+
+void TcpConnection::continueReceive(pointer& self)
 {
     if (triggerhalt) {
         receivingHalt.trigger();
+        notifyPause(false);
         return;
     }
     if (state == ConnectionStates::PRESTART) {
+        if (receivingHalt.isTriggered()) {
+            // a paused loop leaves the trigger fired, it has to be rearmed
+            // or a close would not wait for the new loop
+            receivingHalt.reset();
+        }
         receivingHalt.activate();
         connected.activate();
         state = ConnectionStates::WAITING;
@@ -36,27 +53,136 @@ void TcpConnection::startReceive()
         if (!receivingHalt.isActive()) {
             receivingHalt.activate();
         }
-        if (!triggerhalt) {
+        if (!triggerhalt && !pauseRequested) {
+            // the reference from the previous read is reused so the
+            // steady state loop does not touch the reference count
+            readSelf = (self) ? std::move(self) : shared_from_this();
             socket_->async_read_some(
-                data.data() + residBufferSize,
-                data.size() - residBufferSize,
-                [ptr = shared_from_this()](
-                    const std::error_code& err, size_t bytes) {
-                    ptr->handle_read(err, bytes);
-                });
-            if (triggerhalt) {
+                readLocation(), readSpace(), static_cast<ReadHandler&>(*this));
+            if (triggerhalt || pauseRequested) {
                 // cancel previous operation if triggerhalt is now active
                 socket_->cancel();
                 // receivingHalt.trigger();
             }
+        } else if (triggerhalt) {
+            receiveHalted();
         } else {
-            state = ConnectionStates::HALTED;
-            receivingHalt.trigger();
+            receivePaused();
         }
     } else if (exp != ConnectionStates::OPERATING) {
         /*either halted or closed*/
         receivingHalt.trigger();
+        notifyPause(false);
+    }
+}
+
+void TcpConnection::pauseReceive(std::function<void(bool)> pauseFunc)
+{
+    auto current = state.load();
+    if (current == ConnectionStates::PRESTART) {
+        pauseFunc(!triggerhalt.load());
+        return;
+    }
+    if (current != ConnectionStates::WAITING &&
+        current != ConnectionStates::OPERATING) {
+        pauseFunc(false);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pauseLock);
+        if (pauseCall) {
+            // a pause is already in progress
+            pauseFunc(false);
+            return;
+        }
+        pauseCall = std::move(pauseFunc);
+        pauseRequested.store(true);
+    }
+    // the loop sees the request either when the cancelled read completes or
+    // before it issues the next one, the cancel runs on the strand of the
+    // socket so it can't race a read handler on another thread
+    asio::dispatch(socket_->get_executor(), [self = shared_from_this()]() {
+        self->socket_->cancel();
+        if (!self->isReceiving()) {
+            // the loop ended before the request was made
+            self->notifyPause(
+                self->state.load() == ConnectionStates::PRESTART);
+        }
+    });
+}
+
+void TcpConnection::receivePaused()
+{
+    pauseRequested.store(false);
+    state = ConnectionStates::PRESTART;
+    receivingHalt.trigger();
+    notifyPause(true);
+}
+
+void TcpConnection::receiveHalted()
+{
+    state = ConnectionStates::HALTED;
+    pauseRequested.store(false);
+    receivingHalt.trigger();
+    notifyPause(false);
+}
+
+void TcpConnection::notifyPause(bool paused)
+{
+    std::function<void(bool)> call;
+    {
+        std::lock_guard<std::mutex> lock(pauseLock);
+        call = std::move(pauseCall);
+        pauseCall = nullptr;
+    }
+    if (call) {
+        call(paused);
+    }
+}
+
+bool TcpConnection::setReceiveBufferMode(ReceiveBufferMode mode)
+{
+    if (state.load() != ConnectionStates::PRESTART) {
+        throw(std::runtime_error(
+            "cannot change the receive buffer after socket is started"));
+    }
+    if (mode == ReceiveBufferMode::VECTOR) {
+        if (ringBuffer) {
+            data.resize(ringBuffer->capacity());
+            ringBuffer.reset();
+            nominalBufferSize = data.size();
+        }
+        return true;
     }
+    if (!ringBuffer) {
+        try {
+            ringBuffer = std::make_unique<MirroredBuffer>(data.size());
+        }
+        catch (const std::system_error& se) {
+            logger(
+                1,
+                std::string("mirrored receive buffer unavailable ") +
+                    se.what());
+            return false;
+        }
+        // the ring replaces the vector so don't keep the memory around
+        std::vector<char>().swap(data);
+        nominalBufferSize = ringBuffer->capacity();
+        maxBufferSize = (std::max)(maxBufferSize, nominalBufferSize);
+    }
+    return true;
+}
+
+void TcpConnection::setMaxBufferSize(size_t maxSize)
+{
+    if (state.load() != ConnectionStates::PRESTART) {
+        throw(std::runtime_error(
+            "cannot change the buffer limit after socket is started"));
+    }
+    if (maxSize == 0) {
+        throw(std::runtime_error("the buffer limit must be greater than 0"));
+    }
+    maxBufferSize = (std::max)(maxSize, nominalBufferSize);
 }
 
 void TcpConnection::setDataCall(
@@ -69,6 +195,55 @@ void TcpConnection::setDataCall(
             "cannot set data callback after socket is started"));
     }
 }
+
+void TcpConnection::setFramingMode(FramingMode mode)
+{
+    if (state.load() == ConnectionStates::PRESTART) {
+        framing = mode;
+    } else {
+        throw(std::runtime_error(
+            "cannot set the framing mode after socket is started"));
+    }
+}
+
+void TcpConnection::setMessageCall(
+    std::function<void(TcpConnection::pointer, const char*, size_t)>
+        messageFunc)
+{
+    if (state.load() == ConnectionStates::PRESTART) {
+        messageCall = std::move(messageFunc);
+    } else {
+        throw(std::runtime_error(
+            "cannot set message callback after socket is started"));
+    }
+}
+
+void TcpConnection::setSendCompletionCall(
+    std::function<void(
+        TcpConnection::pointer,
+        const std::error_code&,
+        size_t messageCount,
+        size_t byteCount)> completionFunc)
+{
+    if (state.load() == ConnectionStates::PRESTART) {
+        sendCompletionCall = std::move(completionFunc);
+    } else {
+        throw(std::runtime_error(
+            "cannot set send completion callback after socket is started"));
+    }
+}
+
+void TcpConnection::setLatencyHistograms(
+    std::shared_ptr<LatencyHistograms> latencyHistograms)
+{
+    if (state.load() == ConnectionStates::PRESTART) {
+        histograms = std::move(latencyHistograms);
+    } else {
+        throw(std::runtime_error(
+            "cannot set latency histograms after socket is started"));
+    }
+}
+
 void TcpConnection::setErrorCall(
     std::function<bool(TcpConnection::pointer, const std::error_code&)>
         errorFunc)
@@ -92,76 +267,251 @@ void TcpConnection::setLoggingFunction(
     }
 }
 
-void TcpConnection::handle_read(
+void TcpConnection::on_read(
     const std::error_code& error,
     size_t bytes_transferred)
+{
+    // only one read is outstanding so its reference can be taken without
+    // synchronization, if the loop stops it is released on return
+    pointer self = std::move(readSelf);
+    increment(counters.asyncReads);
+    if (latency(&LatencyHistograms::dispatch) != nullptr) {
+        readTime = std::chrono::steady_clock::now();
+    }
+    handle_read(error, bytes_transferred, self);
+}
+
+void TcpConnection::handle_read(
+    const std::error_code& error,
+    size_t bytes_transferred,
+    pointer& self)
 {
     if (triggerhalt.load(std::memory_order_acquire)) {
-        state = ConnectionStates::HALTED;
-        receivingHalt.trigger();
+        receiveHalted();
         return;
     }
     if (!error) {
-        auto used = dataCall(
-            shared_from_this(),
-            data.data(),
-            bytes_transferred + residBufferSize);
-        if (used < (bytes_transferred + residBufferSize)) {
-            if (used > 0) {
-                std::copy(
-                    data.data() + used,
-                    data.data() + bytes_transferred + residBufferSize,
-                    data.data());
+        if (!processRead(bytes_transferred)) {
+            return;
+        }
+        // drain data already waiting in the kernel before going back through
+        // the reactor, limited so other connections on the context get a turn
+        std::error_code readError;
+        for (size_t ii = 0; ii < readBudget.load(std::memory_order_relaxed);
+             ++ii) {
+            if (triggerhalt.load(std::memory_order_acquire) ||
+                pauseRequested.load(std::memory_order_acquire)) {
+                break;
+            }
+            auto bytes =
+                socket_->try_read_some(readLocation(), readSpace(), readError);
+            if (readError) {
+                break;
+            }
+            increment(counters.speculativeReads);
+            if (latency(&LatencyHistograms::dispatch) != nullptr) {
+                readTime = std::chrono::steady_clock::now();
+            }
+            if (!processRead(bytes)) {
+                return;
             }
-            residBufferSize = bytes_transferred + residBufferSize - used;
-        } else {
-            residBufferSize = 0;
-            data.assign(data.size(), 0);
+        }
+        if (readError && readError != asio::error::would_block) {
+            handle_read(readError, 0, self);
+            return;
         }
         state = ConnectionStates::WAITING;
-        startReceive();
+        continueReceive(self);
     } else if (error == asio::error::operation_aborted) {
-        state = ConnectionStates::HALTED;
-        receivingHalt.trigger();
+        if (pauseRequested.load()) {
+            receivePaused();
+            return;
+        }
+        receiveHalted();
         return;
     } else {
         // there was an error
+        if (error != asio::error::eof) {
+            increment(counters.errors);
+        }
         if (bytes_transferred > 0) {
-            auto used = dataCall(
-                shared_from_this(),
-                data.data(),
-                bytes_transferred + residBufferSize);
-            if (used < (bytes_transferred + residBufferSize)) {
-                if (used > 0) {
-                    std::copy(
-                        data.data() + used,
-                        data.data() + bytes_transferred + residBufferSize,
-                        data.data());
-                }
-                residBufferSize = bytes_transferred + residBufferSize - used;
-            } else {
-                residBufferSize = 0;
-            }
+            increment(counters.bytesReceived, bytes_transferred);
+            processReceivedData(bytes_transferred, false);
         }
         if (errorCall) {
-            if (errorCall(shared_from_this(), error)) {
+            bool resume{false};
+            {
+                ScopedLatency timer(latency(&LatencyHistograms::callback));
+                resume = errorCall(shared_from_this(), error);
+            }
+            if (resume) {
+                if (!adjustReceiveBuffer()) {
+                    receiveFailure(asio::error::message_size);
+                    return;
+                }
                 state = ConnectionStates::WAITING;
-                startReceive();
+                continueReceive(self);
             } else {
-                state = ConnectionStates::HALTED;
-                receivingHalt.trigger();
+                receiveHalted();
             }
         } else if (error != asio::error::eof) {
             if (error != asio::error::connection_reset) {
                 logger(0, std::string("receive error ") + error.message());
             }
-            state = ConnectionStates::HALTED;
-            receivingHalt.trigger();
+            receiveHalted();
         } else {
-            state = ConnectionStates::HALTED;
-            receivingHalt.trigger();
+            receiveHalted();
+        }
+    }
+}
+
+bool TcpConnection::processRead(size_t bytes_transferred)
+{
+    increment(counters.bytesReceived, bytes_transferred);
+    auto dataError = processReceivedData(bytes_transferred, true);
+    if (dataError) {
+        receiveFailure(dataError);
+        return false;
+    }
+    if (!adjustReceiveBuffer()) {
+        receiveFailure(asio::error::message_size);
+        return false;
+    }
+    return true;
+}
+
+std::error_code TcpConnection::processReceivedData(
+    size_t bytes_transferred,
+    bool clearBuffer)
+{
+    std::error_code dataError;
+    if (ringBuffer) {
+        // the ring is contiguous through the mirror so nothing is moved
+        ringBuffer->commit(bytes_transferred);
+        auto used =
+            deliverData(ringBuffer->data(), ringBuffer->size(), dataError);
+        ringBuffer->consume((std::min)(used, ringBuffer->size()));
+        residBufferSize = ringBuffer->size();
+        if (residBufferSize > 0) {
+            increment(counters.residualCarryovers);
+        }
+        return dataError;
+    }
+    auto used = deliverData(
+        data.data(), bytes_transferred + residBufferSize, dataError);
+    if (used < (bytes_transferred + residBufferSize)) {
+        if (used > 0) {
+            std::copy(
+                data.data() + used,
+                data.data() + bytes_transferred + residBufferSize,
+                data.data());
+        }
+        residBufferSize = bytes_transferred + residBufferSize - used;
+        increment(counters.residualCarryovers);
+    } else {
+        residBufferSize = 0;
+        if (clearBuffer) {
+            data.assign(data.size(), 0);
+        }
+    }
+    return dataError;
+}
+
+size_t TcpConnection::deliverData(
+    const char* buffer,
+    size_t dataLength,
+    std::error_code& error)
+{
+    if (framing == FramingMode::NONE) {
+        increment(counters.messagesReceived);
+        recordDispatch();
+        ScopedLatency timer(latency(&LatencyHistograms::callback));
+        return dataCall(shared_from_this(), buffer, dataLength);
+    }
+    if (!messageCall) {
+        // framed data with nowhere to deliver it
+        error = std::make_error_code(std::errc::operation_not_supported);
+        return 0;
+    }
+    auto self = shared_from_this();
+    return parseFrames(
+        framing,
+        buffer,
+        dataLength,
+        (maxBufferSize > maxFrameHeaderSize) ?
+            maxBufferSize - maxFrameHeaderSize :
+            0,
+        [this, &self](const char* message, size_t messageLength) {
+            increment(counters.messagesReceived);
+            recordDispatch();
+            ScopedLatency timer(latency(&LatencyHistograms::callback));
+            messageCall(self, message, messageLength);
+        },
+        error);
+}
+
+bool TcpConnection::adjustReceiveBuffer()
+{
+    const size_t capacity = getBufferCapacity();
+    const size_t stored = residBufferSize.load();
+    if (stored < capacity) {
+        if (stored == 0 && capacity > nominalBufferSize) {
+            // the large message has been handled so release the extra memory
+            if (ringBuffer) {
+                try {
+                    ringBuffer =
+                        std::make_unique<MirroredBuffer>(nominalBufferSize);
+                }
+                catch (const std::system_error&) {
+                    // keep using the larger buffer
+                }
+            } else {
+                std::vector<char>(nominalBufferSize).swap(data);
+            }
+        }
+        return true;
+    }
+    if (capacity >= maxBufferSize) {
+        return false;
+    }
+    // a buffer created with no space still has to start growing
+    const size_t start = (std::max)({capacity, nominalBufferSize, size_t{1}});
+    const size_t newCapacity = (std::min)(start * 2, maxBufferSize);
+    if (ringBuffer) {
+        std::unique_ptr<MirroredBuffer> grown;
+        try {
+            grown = std::make_unique<MirroredBuffer>(newCapacity);
+        }
+        catch (const std::system_error& se) {
+            logger(
+                0, std::string("unable to grow receive buffer ") + se.what());
+            return false;
         }
+        std::copy(
+            ringBuffer->data(),
+            ringBuffer->data() + ringBuffer->size(),
+            grown->writeLocation());
+        grown->commit(ringBuffer->size());
+        ringBuffer = std::move(grown);
+    } else {
+        data.resize(newCapacity);
     }
+    return true;
+}
+
+void TcpConnection::receiveFailure(const std::error_code& error)
+{
+    increment(counters.errors);
+    if (errorCall) {
+        ScopedLatency timer(latency(&LatencyHistograms::callback));
+        errorCall(shared_from_this(), error);
+    } else {
+        logger(
+            0,
+            std::string("unable to process received data ") +
+                error.message());
+    }
+    receiveHalted();
 }
 
 void TcpConnection::logger(int logLevel, const std::string& message)
@@ -223,25 +573,63 @@ void TcpConnection::closeNoWait()
 /** wait on the closing actions*/
 void TcpConnection::waitOnClose()
 {
-    if (triggerhalt.load(std::memory_order_acquire)) {
-        if (connecting) {
-            connected.waitActivation();
-        }
+    // a close normally finishes as soon as the aborted read is processed
+    constexpr std::chrono::seconds slowCloseReport{2};
+    if (waitOnClose(std::chrono::steady_clock::now() + slowCloseReport)) {
+        return;
+    }
+    std::stringstream str;
+    str << "connection " << idcode << " slow to close, state "
+        << static_cast<int>(state.load()) << " socket open "
+        << socket_->is_open() << " context stopped " << context_.stopped();
+    logger(1, str.str());
+    if (connecting) {
+        connected.waitActivation();
+    }
+    receivingHalt.wait();
+    state.store(ConnectionStates::CLOSED);
+}
 
-        while (!receivingHalt.wait_for(std::chrono::milliseconds(200))) {
-            std::stringstream str;
-            str << "wait timeout " << static_cast<int>(state.load()) << " "
-                << socket_->is_open() << " " << receivingHalt.isTriggered();
-            logger(1, str.str());
-            str.clear();
+/** get the time left before a deadline rounded up to whole milliseconds*/
+static std::chrono::milliseconds
+    remainingTime(std::chrono::steady_clock::time_point deadline)
+{
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    return (remaining > 0ms) ? remaining : 0ms;
+}
 
-            str << "wait info " << context_.stopped() << " " << connecting;
-            logger(1, str.str());
-        }
-    } else {
-        close();
+bool TcpConnection::waitOnClose(std::chrono::steady_clock::time_point deadline)
+{
+    if (!triggerhalt.load(std::memory_order_acquire)) {
+        closeNoWait();
+    }
+    if (connecting && !connected.wait_forActivation(remainingTime(deadline))) {
+        return false;
+    }
+    if (!receivingHalt.wait_for(remainingTime(deadline))) {
+        return false;
     }
     state.store(ConnectionStates::CLOSED);
+    return true;
+}
+
+TcpConnection::pointer TcpConnection::create(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::string& connection,
+    const std::string& port,
+    size_t bufferSize)
+{
+    // an unresolvable host is reported by throwing, the result is cached so
+    // the connect does not resolve the host again
+    std::error_code ec;
+    ResolutionCache::instance()->resolve(
+        io_context, tcp::v4(), connection, port, ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
+    return create(sf, io_context, connection, port, nullptr, bufferSize);
 }
 
 TcpConnection::pointer TcpConnection::create(
@@ -249,10 +637,13 @@ TcpConnection::pointer TcpConnection::create(
     asio::io_context& io_context,
     const std::string& connection,
     const std::string& port,
+    ConnectCallback connectFunc,
     size_t bufferSize)
 {
     auto ptr = pointer(new TcpConnection(sf, io_context, bufferSize));
 
+    ptr->connectCall = std::move(connectFunc);
+    ptr->connectPending = true;
     ptr->socket_->async_connect(
         connection, port, [ptr](const std::error_code& error) {
             ptr->connect_handler(error);
@@ -263,64 +654,446 @@ TcpConnection::pointer TcpConnection::create(
 // connect callback used by the client establishing a TCP connection
 void TcpConnection::connect_handler(const std::error_code& error)
 {
-    if (!error) {
-        socket_->handshake();
-        connected.activate();
-        socket_->set_option_no_delay(true);
-    } else {
-        std::stringstream str;
+    if (error) {
+        connectFailed(error);
+        return;
+    }
+    socket_->set_option_no_delay(true);
+    // the connection is not usable until the handshake completes, which is
+    // done asynchronously so encrypted connections do not stall the context
+    socket_->async_handshake(
+        [self = shared_from_this()](const std::error_code& handshakeError) {
+            self->handshake_handler(handshakeError);
+        });
+}
 
-        str << "connection error " << error.message()
-            << ": code =" << error.value();
-        logger(0, str.str());
-        connectionError = true;
-        connected.activate();
+void TcpConnection::handshake_handler(const std::error_code& error)
+{
+    if (error) {
+        connectFailed(error);
+        return;
+    }
+    bool backlog{false};
+    {
+        std::lock_guard<std::mutex> lock(sendLock);
+        connectPending = false;
+        connectQueueBytes = 0;
+        // later sends keep going through the queue until it is empty so
+        // they cannot overtake the queued data
+        backlog = !sendQueue.empty();
+        if (backlog) {
+            sendActive = true;
+            connectBacklog = true;
+        }
+    }
+    connected.activate();
+    if (backlog) {
+        flushSendQueue();
+    }
+    if (connectCall) {
+        auto call = std::move(connectCall);
+        connectCall = nullptr;
+        call(shared_from_this(), error);
+    }
+}
+
+void TcpConnection::connectFailed(const std::error_code& error)
+{
+    std::stringstream str;
+
+    str << "connection error " << error.message()
+        << ": code =" << error.value();
+    logger(0, str.str());
+    std::deque<PendingSend> failed;
+    {
+        std::lock_guard<std::mutex> lock(sendLock);
+        connectPending = false;
+        connectQueueBytes = 0;
+        failed.swap(sendQueue);
+    }
+    connectionError = true;
+    connected.activate();
+    increment(counters.errors);
+    pendingSends -= failed.size();
+    for (auto& pending : failed) {
+        if (pending.callback) {
+            pending.callback(error, 0);
+        }
+        if (pending.release) {
+            pending.release();
+        }
+    }
+    if (connectCall) {
+        auto call = std::move(connectCall);
+        connectCall = nullptr;
+        call(shared_from_this(), error);
+    }
+    if (errorCall) {
+        ScopedLatency timer(latency(&LatencyHistograms::callback));
+        errorCall(shared_from_this(), error);
     }
 }
 size_t TcpConnection::send(const void* buffer, size_t dataLength)
 {
+    return sendBuffers(nullptr, 0, buffer, dataLength);
+}
+
+size_t TcpConnection::send(const std::string& dataString)
+{
+    size_t sz;
+    sz = send(&dataString[0], dataString.size());
+    return sz;
+}
+
+size_t TcpConnection::sendMessage(const void* buffer, size_t dataLength)
+{
+    std::array<char, maxFrameHeaderSize> header;
+    auto headerSize = encodeFrameHeader(framing, dataLength, header.data());
+    if (framing != FramingMode::NONE && headerSize == 0) {
+        // the message is too long for the framing mode
+        return 0;
+    }
+    return sendBuffers(header.data(), headerSize, buffer, dataLength);
+}
+
+size_t TcpConnection::sendBuffers(
+    const char* header,
+    size_t headerSize,
+    const void* buffer,
+    size_t dataLength)
+{
+    // the header and body are queued together so nothing can come between
+    // them
+    auto queueCopy = [&]() {
+        PendingSend pending;
+        pending.data.reserve(headerSize + dataLength);
+        if (headerSize > 0) {
+            pending.data.assign(header, headerSize);
+        }
+        pending.data.append(static_cast<const char*>(buffer), dataLength);
+        return queueSend(std::move(pending)) ? dataLength : size_t{0};
+    };
+    if (connectPending.load() || connectBacklog.load()) {
+        return queueCopy();
+    }
     if (!isConnected()) {
         if (!waitUntilConnected(300ms)) {
             logger(0, "connection timeout waiting again");
         }
         if (!waitUntilConnected(200ms)) {
             logger(0, "connection timeout twice, now returning");
+            increment(counters.errors);
             return 0;
         }
     }
+    {
+        std::unique_lock<std::mutex> lock(sendLock);
+        if (sendActive || !sendQueue.empty()) {
+            // another write owns the socket so go behind it in the queue
+            // rather than blocking, this may be a callback of that write
+            lock.unlock();
+            return queueCopy();
+        }
+        // asynchronous sends queue behind this write until it is done
+        sendActive = true;
+    }
+    auto releaseSocket = [this]() {
+        bool morePending{false};
+        {
+            std::lock_guard<std::mutex> lock(sendLock);
+            morePending = !sendQueue.empty();
+            sendActive = morePending;
+        }
+        if (morePending) {
+            flushSendQueue();
+        }
+    };
 
-    size_t sz{0};
-    size_t sent_size{dataLength};
-    size_t p{0};
+    ScopedLatency timer(latency(&LatencyHistograms::send));
+    std::array<asio::const_buffer, 2> buffers{
+        asio::const_buffer(header, headerSize),
+        asio::const_buffer(buffer, dataLength)};
+    const size_t total{headerSize + dataLength};
+    size_t sent{0};
     int count{0};
-    while (count++ < 5 &&
-           (sz = socket_->write_some(
-                reinterpret_cast<const char*>(buffer) + p, sent_size)) !=
-               sent_size) {
-        sent_size -= sz;
-        p += sz;
-        //   std::cerr << "DEBUG partial buffer sent" << std::endl;
-    }
-    if (count >= 5) {
+    try {
+        while (count++ < 5) {
+            auto sz = socket_->write_some(buffers);
+            sent += sz;
+            if (sent >= total) {
+                break;
+            }
+            increment(counters.partialWrites);
+            for (auto& remaining : buffers) {
+                const auto used = (std::min)(sz, remaining.size());
+                remaining += used;
+                sz -= used;
+            }
+        }
+    }
+    catch (...) {
+        increment(counters.bytesSent, sent);
+        releaseSocket();
+        throw;
+    }
+    increment(counters.bytesSent, sent);
+    releaseSocket();
+    if (sent < total) {
+        increment(counters.errors);
         logger(0, "TcpConnection send terminated");
         return 0;
     }
+    increment(counters.messagesSent);
     return dataLength;
+}
 
-    //  assert(sz == dataLength);
-    //  return sz;
+void TcpConnection::asyncSend(std::string message, SendCallback callback)
+{
+    PendingSend pending;
+    pending.data = std::move(message);
+    pending.callback = std::move(callback);
+    queueSend(std::move(pending));
 }
 
-size_t TcpConnection::send(const std::string& dataString)
+void TcpConnection::asyncSendZeroCopy(
+    const void* buffer,
+    size_t dataLength,
+    SendCallback callback,
+    std::function<void()> release)
 {
-    size_t sz;
-    sz = send(&dataString[0], dataString.size());
-    return sz;
+    PendingSend pending;
+    pending.external = static_cast<const char*>(buffer);
+    pending.externalSize = dataLength;
+    pending.callback = std::move(callback);
+    pending.release = std::move(release);
+    queueSend(std::move(pending));
+}
+
+bool TcpConnection::setZeroCopyThreshold(size_t threshold)
+{
+    if (threshold == 0 || !socket_->enable_zero_copy()) {
+        zeroCopyThreshold.store(0);
+        return false;
+    }
+    zeroCopyThreshold.store(threshold);
+    return true;
+}
+
+bool TcpConnection::queueSend(PendingSend pending)
+{
+    ++pendingSends;
+    std::unique_lock<std::mutex> lock(sendLock);
+    if (connectPending) {
+        // hold everything until connect_handler starts the queue
+        if (connectQueueBytes + pending.size() > connectQueueLimit.load()) {
+            lock.unlock();
+            --pendingSends;
+            increment(counters.errors);
+            logger(0, "send queue limit reached while connecting");
+            if (pending.callback) {
+                pending.callback(asio::error::no_buffer_space, 0);
+            }
+            if (pending.release) {
+                pending.release();
+            }
+            return false;
+        }
+        connectQueueBytes += pending.size();
+        sendQueue.push_back(std::move(pending));
+        return true;
+    }
+    if (sendActive || !sendQueue.empty() || useZeroCopy(pending.size())) {
+        sendQueue.push_back(std::move(pending));
+        if (sendActive) {
+            return true;
+        }
+        sendActive = true;
+        lock.unlock();
+        flushSendQueue();
+        return true;
+    }
+    sendActive = true;
+    lock.unlock();
+
+    // nothing else is pending so try to write immediately
+    std::error_code error;
+    auto written =
+        socket_->try_write_some(pending.buffer(), pending.size(), error);
+    if (!error && written == pending.size()) {
+        --pendingSends;
+        increment(counters.bytesSent, written);
+        increment(counters.messagesSent);
+        lock.lock();
+        const bool morePending = !sendQueue.empty();
+        sendActive = morePending;
+        lock.unlock();
+        if (pending.callback) {
+            pending.callback(error, written);
+        }
+        if (pending.release) {
+            pending.release();
+        }
+        if (sendCompletionCall) {
+            sendCompletionCall(shared_from_this(), error, 1, written);
+        }
+        if (morePending) {
+            flushSendQueue();
+        }
+        return true;
+    }
+    // the remainder goes ahead of anything queued in the meantime, any error
+    // other than would_block is reported by the asynchronous write
+    if (written > 0) {
+        increment(counters.bytesSent, written);
+        increment(counters.partialWrites);
+    }
+    pending.offset = written;
+    lock.lock();
+    sendQueue.push_front(std::move(pending));
+    lock.unlock();
+    flushSendQueue();
+    return true;
+}
+
+void TcpConnection::flushSendQueue()
+{
+    std::shared_ptr<PendingSend> zeroCopySend;
+    {
+        std::lock_guard<std::mutex> lock(sendLock);
+        if (sendQueue.empty()) {
+            sendActive = false;
+            connectBacklog = false;
+            return;
+        }
+        auto& front = sendQueue.front();
+        if (useZeroCopy(front.size() - front.offset)) {
+            zeroCopySend = std::make_shared<PendingSend>(std::move(front));
+            sendQueue.pop_front();
+        } else {
+            // large messages are left for their own zero copy write
+            auto last = std::find_if(
+                sendQueue.begin(),
+                sendQueue.end(),
+                [this](const PendingSend& pending) {
+                    return useZeroCopy(pending.size());
+                });
+            sendBatch.reserve(std::distance(sendQueue.begin(), last));
+            std::move(sendQueue.begin(), last, std::back_inserter(sendBatch));
+            sendQueue.erase(sendQueue.begin(), last);
+        }
+    }
+    if (zeroCopySend) {
+        sendZeroCopy(std::move(zeroCopySend));
+        return;
+    }
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(sendBatch.size());
+    for (const auto& pending : sendBatch) {
+        buffers.emplace_back(
+            pending.buffer() + pending.offset, pending.size() - pending.offset);
+    }
+    socket_->async_write(
+        buffers,
+        [ptr = shared_from_this()](
+            const std::error_code& error, size_t bytes_written) {
+            ptr->handle_write(error, bytes_written);
+        });
+}
+
+void TcpConnection::sendZeroCopy(std::shared_ptr<PendingSend> pending)
+{
+    // the release callback owns the data and keeps the socket alive until
+    // the kernel is done with it
+    socket_->async_write_zero_copy(
+        pending->buffer() + pending->offset,
+        pending->size() - pending->offset,
+        [ptr = shared_from_this(),
+         pending](const std::error_code& error, size_t bytes_written) {
+            if (pending->callback) {
+                pending->callback(error, (error) ? size_t{0} : pending->size());
+            }
+            ptr->finishWrite(error, 1, bytes_written);
+        },
+        [ptr = shared_from_this(), pending]() {
+            if (pending->release) {
+                pending->release();
+            }
+        });
+}
+
+void TcpConnection::handle_write(
+    const std::error_code& error,
+    size_t bytes_written)
+{
+    for (auto& pending : sendBatch) {
+        if (pending.callback) {
+            pending.callback(error, (error) ? size_t{0} : pending.size());
+        }
+        if (pending.release) {
+            pending.release();
+        }
+    }
+    const auto messageCount = sendBatch.size();
+    sendBatch.clear();
+    finishWrite(error, messageCount, bytes_written);
+}
+
+void TcpConnection::finishWrite(
+    const std::error_code& error,
+    size_t messageCount,
+    size_t bytes_written)
+{
+    pendingSends -= messageCount;
+    increment(counters.bytesSent, bytes_written);
+    if (error) {
+        increment(counters.errors);
+        logger(0, std::string("queued send failed ") + error.message());
+    } else {
+        increment(counters.messagesSent, messageCount);
+    }
+    if (sendCompletionCall) {
+        sendCompletionCall(
+            shared_from_this(), error, messageCount, bytes_written);
+    }
+    flushSendQueue();
 }
 
 size_t TcpConnection::receive(void* buffer, size_t maxDataSize)
 {
-    return socket_->read_some(buffer, maxDataSize);
+    auto bytes = socket_->read_some(buffer, maxDataSize);
+    increment(counters.bytesReceived, bytes);
+    return bytes;
+}
+
+void TcpConnection::countSend(
+    const std::error_code& error,
+    size_t bytes_transferred,
+    size_t dataLength)
+{
+    increment(counters.bytesSent, bytes_transferred);
+    if (error) {
+        increment(counters.errors);
+    } else if (bytes_transferred < dataLength) {
+        increment(counters.partialWrites);
+    } else {
+        increment(counters.messagesSent);
+    }
+}
+
+TcpConnection::Statistics TcpConnection::getStatistics() const
+{
+    constexpr auto order = std::memory_order_relaxed;
+    Statistics stats;
+    stats.bytesSent = counters.bytesSent.load(order);
+    stats.bytesReceived = counters.bytesReceived.load(order);
+    stats.messagesSent = counters.messagesSent.load(order);
+    stats.messagesReceived = counters.messagesReceived.load(order);
+    stats.partialWrites = counters.partialWrites.load(order);
+    stats.residualCarryovers = counters.residualCarryovers.load(order);
+    stats.asyncReads = counters.asyncReads.load(order);
+    stats.speculativeReads = counters.speculativeReads.load(order);
+    stats.errors = counters.errors.load(order);
+    return stats;
 }
 
 bool TcpConnection::waitUntilConnected(std::chrono::milliseconds timeOut)
@@ -7,14 +7,21 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
 #include "GuardedTypes.hpp"
+#include "LatencyHistogram.hpp"
+#include "MessageFraming.hpp"
+#include "MirroredBuffer.hpp"
 #include "Socket.h"
 #include "SocketFactory.h"
 #include "gmlc/concurrency/TriggerVariable.hpp"
 
+#include <algorithm>
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,7 +32,9 @@ various helper classes and functions for handling TCP connections
 namespace gmlc {
 namespace networking {
     /** tcp socket generation for a receiving server*/
-    class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
+    class TcpConnection :
+        public std::enable_shared_from_this<TcpConnection>,
+        private ReadHandler {
       public:
         /** enumeration of the possible states of a connection*/
         enum class ConnectionStates {
@@ -35,11 +44,56 @@ namespace networking {
             HALTED = 3,
             CLOSED = 4,
         };
+        /** enumeration of the storage used for received data*/
+        enum class ReceiveBufferMode {
+            VECTOR = 0,  //!< a vector with residual data moved to the front
+            MIRRORED = 1,  //!< a ring buffer using mirrored virtual memory
+        };
 
         using pointer = std::shared_ptr<TcpConnection>;
+        /** a snapshot of the traffic counters of a connection*/
+        struct Statistics {
+            size_t bytesSent{0};
+            size_t bytesReceived{0};
+            size_t messagesSent{0};  //!< completed send calls or messages
+            /// calls to the data callback or framed messages delivered
+            size_t messagesReceived{0};
+            size_t partialWrites{0};  //!< writes that did not send all data
+            /// reads after which unused data was kept in the buffer
+            size_t residualCarryovers{0};
+            size_t asyncReads{0};  //!< reads that waited on the socket
+            size_t speculativeReads{0};  //!< reads made without waiting
+            size_t errors{0};  //!< failed sends and receives
+
+            Statistics& operator+=(const Statistics& other)
+            {
+                bytesSent += other.bytesSent;
+                bytesReceived += other.bytesReceived;
+                messagesSent += other.messagesSent;
+                messagesReceived += other.messagesReceived;
+                partialWrites += other.partialWrites;
+                residualCarryovers += other.residualCarryovers;
+                asyncReads += other.asyncReads;
+                speculativeReads += other.speculativeReads;
+                errors += other.errors;
+                return *this;
+            }
+        };
+        /// callback for completion of a single queued send
+        using SendCallback =
+            std::function<void(const std::error_code&, size_t)>;
+        /// callback for the completion of an outgoing connection
+        using ConnectCallback =
+            std::function<void(const pointer&, const std::error_code&)>;
+        /// the default limit on the size the receive buffer can grow to
+        static constexpr size_t defaultMaxBufferSize{64U * 1024U * 1024U};
+        /// the default limit on the data queued while a connection is made
+        static constexpr size_t defaultConnectQueueLimit{1024U * 1024U};
         /** create a connection to the specified host+port
          *
-         * @throws std::system_error thrown on failure
+         * @details the host is resolved through the shared ResolutionCache
+         * before returning, the connection itself is made asynchronously
+         * @throws std::system_error if the host can't be resolved
          */
         static pointer create(
             asio::io_context& io_context,
@@ -53,7 +107,9 @@ namespace networking {
         /** create a connection to the specified host+port using the given
          * SocketFactory
          *
-         * @throws std::system_error thrown on failure
+         * @details the host is resolved through the shared ResolutionCache
+         * before returning, the connection itself is made asynchronously
+         * @throws std::system_error if the host can't be resolved
          */
         static pointer create(
             const SocketFactory& sf,
@@ -61,6 +117,21 @@ namespace networking {
             const std::string& connection,
             const std::string& port,
             size_t bufferSize = 10192);
+        /** create a connection to the specified host+port and get notified
+         * when it completes
+         *
+         * @details the host is resolved asynchronously so this never blocks,
+         * a failed resolution is reported through the callback.  The callback
+         * is called once, when the connection and any handshake have completed
+         * or with the error that stopped them, and before the error callback
+         */
+        static pointer create(
+            const SocketFactory& sf,
+            asio::io_context& io_context,
+            const std::string& connection,
+            const std::string& port,
+            ConnectCallback connectFunc,
+            size_t bufferSize = 10192);
         /** create an RxConnection object using the specified context and
          * bufferSize
          *
@@ -92,10 +163,108 @@ namespace networking {
         void close();
         /** perform the close actions but don't wait for them to be processed*/
         void closeNoWait();
-        /** wait on the closing actions*/
+        /** wait on the closing actions
+        @details blocks until the outstanding read handler has completed, a
+        single message is logged if that takes unusually long*/
         void waitOnClose();
+        /** wait on the closing actions until a deadline
+        @details starts the close if it has not been started already
+        @return true if the connection finished closing before the deadline
+        */
+        bool waitOnClose(std::chrono::steady_clock::time_point deadline);
+        /** stop the receive loop without closing the connection
+        @details the outstanding read is cancelled and the connection returns
+        to the state it had before startReceive, so the callbacks and other
+        settings can be changed and the loop started again.  Data received
+        but not consumed by the callbacks stays in the buffer.  Cancelling
+        the read also aborts queued asynchronous sends, so they should be
+        complete before pausing.  This can be called from inside a callback,
+        the loop stops once the callback returns.
+        @param pauseFunc called once the loop has stopped, from the strand of
+        the socket or from inside this call, with true if the
+        loop can be started again and false if the connection halted or
+        closed instead
+        */
+        void pauseReceive(std::function<void(bool paused)> pauseFunc);
         /**check if the connection is receiving data*/
-        bool isReceiving() const { return receivingHalt.isActive(); }
+        bool isReceiving() const
+        {
+            return receivingHalt.isActive() && !receivingHalt.isTriggered();
+        }
+        /** get the number of received bytes held in the buffer that were not
+         * consumed by the callbacks*/
+        size_t getBufferedDataSize() const { return residBufferSize.load(); }
+        /** set the type of buffer used to store received data
+        @details the mirrored ring buffer never copies or clears data between
+        reads, and the data callback always sees a contiguous block.  If the
+        platform cannot create the mirrored mapping the vector buffer remains in
+        use.
+        @return true if the requested mode is in use
+        @throws std::runtime_error if called after the receive loop started
+        */
+        bool setReceiveBufferMode(ReceiveBufferMode mode);
+        /** set the maximum size the receive buffer can grow to
+        @details if the data callback does not consume any data from a full
+        receive buffer, the buffer is doubled in size up to this limit, and
+        returns to the original size once it has been emptied.  If the limit
+        is reached the error callback is called with asio::error::message_size
+        and the receive loop halts.
+        @throws std::runtime_error if called after the receive loop started
+        or if the size is 0
+        */
+        void setMaxBufferSize(size_t maxSize);
+        /** get the maximum size the receive buffer can grow to*/
+        size_t getMaxBufferSize() const { return maxBufferSize; }
+        /** get the current capacity of the receive buffer*/
+        size_t getBufferCapacity() const
+        {
+            return (ringBuffer) ? ringBuffer->capacity() : data.size();
+        }
+        /** set the number of non-blocking reads attempted after each read
+        completes before waiting on the socket again
+        @details while data keeps arriving this avoids a trip through the
+        reactor for every read, the limit keeps one busy connection from
+        starving the others on the same context.  0 (the default) disables
+        the extra reads.  Only unencrypted connections on posix systems can
+        read without waiting.
+        */
+        void setReadBudget(size_t budget) { readBudget.store(budget); }
+        /** get the number of non-blocking reads attempted after each read*/
+        size_t getReadBudget() const { return readBudget.load(); }
+        /** get the number of reads that waited on the socket*/
+        size_t getAsyncReadCount() const
+        {
+            return counters.asyncReads.load(std::memory_order_relaxed);
+        }
+        /** get the number of reads made without waiting on the socket*/
+        size_t getSpeculativeReadCount() const
+        {
+            return counters.speculativeReads.load(std::memory_order_relaxed);
+        }
+        /** get a snapshot of the traffic counters
+        @details the counters are updated independently so the values may be
+        from slightly different moments if traffic is ongoing*/
+        Statistics getStatistics() const;
+        /** set the histograms used to record callback and send latencies
+        @details the same histograms may be shared by any number of
+        connections, a null pointer (the default) turns recording off.  If the
+        library is built with GMLC_NETWORKING_DISABLE_HISTOGRAMS nothing is
+        recorded.
+        @throws std::runtime_error if called after the receive loop started
+        */
+        void setLatencyHistograms(
+            std::shared_ptr<LatencyHistograms> latencyHistograms);
+        /** get the histograms recording latencies, may be null*/
+        const std::shared_ptr<LatencyHistograms>& getLatencyHistograms() const
+        {
+            return histograms;
+        }
+        /** get the type of buffer used to store received data*/
+        ReceiveBufferMode getReceiveBufferMode() const
+        {
+            return (ringBuffer) ? ReceiveBufferMode::MIRRORED :
+                                  ReceiveBufferMode::VECTOR;
+        }
         /** set the callback for the data object
          *
          * @throws std::runtime_error thrown on failure
@@ -103,6 +272,36 @@ namespace networking {
         void setDataCall(
             std::function<size_t(TcpConnection::pointer, const char*, size_t)>
                 dataFunc);
+        /** set the length header format used to split the stream into
+        messages
+        @details if set to anything other than FramingMode::NONE the message
+        callback is called for every complete message in place of the data
+        callback, if no message callback is set the receive loop reports
+        std::errc::operation_not_supported through the error callback and halts
+        @throws std::runtime_error if called after the receive loop started
+        */
+        void setFramingMode(FramingMode mode);
+        /** get the length header format used to split the stream*/
+        FramingMode getFramingMode() const { return framing; }
+        /** set the callback for complete messages in framed mode
+        @details the data pointer refers directly into the receive buffer and
+        is only valid for the duration of the callback
+        @throws std::runtime_error if called after the receive loop started
+        */
+        void setMessageCall(
+            std::function<void(TcpConnection::pointer, const char*, size_t)>
+                messageFunc);
+        /** set a callback executed after each batch of queued sends is written
+        @details the callback receives the error (if any) along with the number
+        of messages and bytes in the batch
+        @throws std::runtime_error if called after the receive loop started
+        */
+        void setSendCompletionCall(
+            std::function<void(
+                TcpConnection::pointer,
+                const std::error_code&,
+                size_t messageCount,
+                size_t byteCount)> completionFunc);
         /** set the callback for an error
          *
          * @throws std::runtime_error thrown on failure
@@ -118,11 +317,93 @@ namespace networking {
             std::function<void(int loglevel, const std::string& logMessage)>
                 logFunc);
         /** send raw data
+    @details data sent while the connection started by create is still being
+    made is copied and queued, it is written in order as soon as the
+    connection is established.  If the connection fails the error callback is
+    called.  If another send or asynchronous send is being written the data is
+    copied and queued behind it instead of blocking.
+    @return the number of bytes sent or queued, 0 on failure or if the queue
+    limit would be exceeded
     @throws std::system_error on failure*/
         size_t send(const void* buffer, size_t dataLength);
         /** send a string
     @throws std::system_error on failure*/
         size_t send(const std::string& dataString);
+        /** send a message with a length header in the current framing mode
+    @details the header and the message are sent with a single gathered
+    write, or queued together in the same way as send
+    @return the size of the message (not including the header) or 0 on failure
+    or if the message length does not fit in the framing header
+    @throws std::system_error on failure*/
+        size_t sendMessage(const void* buffer, size_t dataLength);
+        /** send a string as a message with a length header
+    @throws std::system_error on failure*/
+        size_t sendMessage(const std::string& message)
+        {
+            return sendMessage(message.data(), message.size());
+        }
+
+        /** queue data to be sent asynchronously
+        @details the connection owns the data until it is written so the
+        caller does not need to keep it alive.  This can be called from any
+        thread; messages are written in the order they were queued without
+        interleaving.  If nothing is pending an immediate non-blocking write is
+        tried first, otherwise everything queued is written with a single
+        vectored write.
+        @param message the data to send
+        @param callback optional function called once the message is written
+        or the write failed, with the error and the size of the message
+        */
+        void asyncSend(std::string message, SendCallback callback = nullptr);
+        /** queue a copy of raw data to be sent asynchronously*/
+        void asyncSend(
+            const void* buffer,
+            size_t dataLength,
+            SendCallback callback = nullptr)
+        {
+            asyncSend(
+                std::string(static_cast<const char*>(buffer), dataLength),
+                std::move(callback));
+        }
+        /** queue caller owned data to be sent asynchronously
+        @details if the data is at or above the zero copy threshold it is sent
+        directly from the caller's memory, otherwise it is copied into the
+        kernel as part of a normal queued write.  Either way the data must not
+        be modified or freed until the release callback is called.
+        @param buffer the data to send
+        @param dataLength the length of the data
+        @param callback optional function called once the data is written or
+        the write failed, with the error and the size of the data
+        @param release function called once the data is no longer used
+        */
+        void asyncSendZeroCopy(
+            const void* buffer,
+            size_t dataLength,
+            SendCallback callback,
+            std::function<void()> release);
+        /** send queued messages at or above a size without copying them into
+        the kernel
+        @details uses MSG_ZEROCOPY so it is only available for unencrypted
+        connections on linux, and the socket must already be open.  Smaller
+        messages are cheaper to copy and keep using the normal path.
+        @param threshold the minimum message size to send without copying, 0
+        to disable
+        @return true if zero copy transmission is in use
+        */
+        bool setZeroCopyThreshold(size_t threshold);
+        /** get the minimum size of a message sent without copying, 0 if
+         * disabled*/
+        size_t getZeroCopyThreshold() const { return zeroCopyThreshold.load(); }
+        /** set the limit on the bytes queued by send and asyncSend while the
+        connection is being made
+        @details data beyond the limit is rejected, send returns 0 and the
+        asyncSend callback receives asio::error::no_buffer_space*/
+        void setConnectQueueLimit(size_t limit) { connectQueueLimit = limit; }
+        /** get the limit on the bytes queued while the connection is made*/
+        size_t getConnectQueueLimit() const { return connectQueueLimit.load(); }
+        /** get the number of messages queued with asyncSend that have not
+         * completed*/
+        size_t getPendingSendCount() const { return pendingSends.load(); }
 
         /** do a blocking receive on the socket
     @throws std::system_error on failure
@@ -140,7 +421,15 @@ namespace networking {
         template<typename Process>
         void send_async(const void* buffer, size_t dataLength, Process callback)
         {
-            socket_->async_write_some(buffer, dataLength, callback);
+            socket_->async_write_some(
+                buffer,
+                dataLength,
+                [connection = shared_from_this(), dataLength, callback](
+                    const std::error_code& error, size_t bytes_transferred) {
+                    connection->countSend(
+                        error, bytes_transferred, dataLength);
+                    callback(error, bytes_transferred);
+                });
         }
         /**perform an asynchronous receive operation
     @param buffer the data to send
@@ -168,13 +457,19 @@ namespace networking {
                 size_t dataLength,
                 const std::error_code& error)> callback)
         {
+            char* readLocation =
+                (ringBuffer) ? ringBuffer->writeLocation() : data.data();
+            size_t readSize =
+                (ringBuffer) ? ringBuffer->freeSpace() : data.size();
             socket_->async_read_some(
-                data,
-                data.size(),
+                readLocation,
+                readSize,
                 [connection = shared_from_this(),
+                 readLocation,
                  callback = std::move(callback)](
                     const std::error_code& error, size_t bytes_transferred) {
-                    connection->handle_read(bytes_transferred, error, callback);
+                    callback(
+                        connection, readLocation, bytes_transferred, error);
                 });
         }
         /** check if the socket has finished the connection process*/
@@ -199,8 +494,36 @@ namespace networking {
         }
         /** calls the handshake function of the underlying socket*/
         void handshake() { socket_->handshake(); }
+        /** start the handshake of the underlying socket without blocking
+        @param callback called when the handshake has finished, the caller must
+        keep the connection alive until then*/
+        void asyncHandshake(
+            std::function<void(const std::error_code&)> callback)
+        {
+            socket_->async_handshake(std::move(callback));
+        }
 
       private:
+        /// a message queued by asyncSend
+        struct PendingSend {
+            std::string data;
+            size_t offset{0};  //!< the number of bytes already written
+            SendCallback callback;
+            /// caller owned data used in place of data if not null
+            const char* external{nullptr};
+            size_t externalSize{0};
+            /// called once the kernel no longer uses caller owned data
+            std::function<void()> release;
+
+            const char* buffer() const
+            {
+                return (external != nullptr) ? external : data.data();
+            }
+            size_t size() const
+            {
+                return (external != nullptr) ? externalSize : data.size();
+            }
+        };
         /** constructors creating a socket*/
         TcpConnection(asio::io_context& io_context, size_t bufferSize) :
             TcpConnection(SocketFactory(), io_context, bufferSize)
@@ -211,33 +534,164 @@ namespace networking {
             asio::io_context& io_context,
             size_t bufferSize) :
             socket_(sf.create_socket(io_context)), context_(io_context),
-            data(bufferSize), idcode(idcounter++)
+            data(bufferSize), nominalBufferSize(bufferSize),
+            maxBufferSize((std::max)(bufferSize, defaultMaxBufferSize)),
+            idcode(idcounter++)
         {
         }
 
+        /** continue the receive loop
+        @param self the reference held by the completed read, moved into
+        readSelf if another read is issued, may be empty*/
+        void continueReceive(pointer& self);
+        /** completion of the persistent read handler*/
+        void on_read(const std::error_code& error, size_t bytes_transferred)
+            override;
         /** function for handling the asynchronous return from a read request*/
-        void
-            handle_read(const std::error_code& error, size_t bytes_transferred);
         void handle_read(
-            size_t message_size,
             const std::error_code& error,
-            std::function<void(
-                TcpConnection::pointer,
-                const char*,
-                size_t,
-                const std::error_code& error)> callback)
+            size_t bytes_transferred,
+            pointer& self);
+        /** update the counters after a send*/
+        void countSend(
+            const std::error_code& error,
+            size_t bytes_transferred,
+            size_t dataLength);
+        /** end the receive loop for a pause, called in place of the next
+         * read*/
+        void receivePaused();
+        /** end the receive loop for an error or a close*/
+        void receiveHalted();
+        /** call the pause callback if a pause is in progress*/
+        void notifyPause(bool paused);
+        /** process the data from a successful read and prepare the buffer
+        for the next one
+        @return false if the receive loop was halted*/
+        bool processRead(size_t bytes_transferred);
+        /** get the location the next read should write to*/
+        char* readLocation()
+        {
+            return (ringBuffer) ? ringBuffer->writeLocation() :
+                                  data.data() + residBufferSize;
+        }
+        /** get the space available for the next read*/
+        size_t readSpace() const
+        {
+            return (ringBuffer) ? ringBuffer->freeSpace() :
+                                  data.size() - residBufferSize;
+        }
+        /** send the received data to the data callback and keep any unused
+        portion in the buffer
+        @return an error if the received data could not be processed*/
+        std::error_code
+            processReceivedData(size_t bytes_transferred, bool clearBuffer);
+        /** send a block of received data to the data or message callback
+        @return the number of bytes used*/
+        size_t deliverData(
+            const char* buffer,
+            size_t dataLength,
+            std::error_code& error);
+        /** grow the receive buffer if it is full or return it to the nominal
+        size once it is empty
+        @return false if the buffer is full and cannot grow any further*/
+        bool adjustReceiveBuffer();
+        /** report an error in the received data and halt the receive loop*/
+        void receiveFailure(const std::error_code& error);
+        /** add a message to the send queue or write it immediately if
+        nothing is pending
+        @return false if the message was rejected because the queue used while
+        connecting is full*/
+        bool queueSend(PendingSend pending);
+        /** send an optional header and a body with blocking writes, or queue
+         * them together while the connection is being made or another write
+         * is in progress
+        @return dataLength or 0 on failure*/
+        size_t sendBuffers(
+            const char* header,
+            size_t headerSize,
+            const void* buffer,
+            size_t dataLength);
+        /** write everything in the send queue, must only be called by the
+         * thread that set sendActive*/
+        void flushSendQueue();
+        /** write a single queued message without copying*/
+        void sendZeroCopy(std::shared_ptr<PendingSend> pending);
+        /** check if a message of the given size should be sent without
+         * copying*/
+        bool useZeroCopy(size_t size) const
+        {
+            auto threshold = zeroCopyThreshold.load();
+            return threshold > 0 && size >= threshold;
+        }
+        /** function for handling the completion of a queued write*/
+        void handle_write(const std::error_code& error, size_t bytes_written);
+        /** update the send state after a write and continue with the queue*/
+        void finishWrite(
+            const std::error_code& error,
+            size_t messageCount,
+            size_t bytes_written);
+
+        /** get one of the latency histograms if recording is enabled
+        @return the histogram or nullptr*/
+        LatencyHistogram*
+            latency(LatencyHistogram LatencyHistograms::*which) const
+        {
+            if constexpr (latencyHistogramsEnabled) {
+                return (histograms) ? &((*histograms).*which) : nullptr;
+            } else {
+                return nullptr;
+            }
+        }
+        /** record the delay since the last read completed*/
+        void recordDispatch() const
         {
-            callback(shared_from_this(), data.data(), message_size, error);
+            if (auto* dispatch = latency(&LatencyHistograms::dispatch)) {
+                dispatch->record(std::chrono::steady_clock::now() - readTime);
+            }
         }
 
         void logger(int level, const std::string& message);
         static std::atomic<int> idcounter;
 
         std::atomic<size_t> residBufferSize{0};
+        /// keeps the connection alive while a read is outstanding
+        pointer readSelf;
+        std::atomic<size_t> readBudget{0};
+        /// the live version of Statistics, only updated with relaxed ordering
+        struct Counters {
+            std::atomic<size_t> bytesSent{0};
+            std::atomic<size_t> bytesReceived{0};
+            std::atomic<size_t> messagesSent{0};
+            std::atomic<size_t> messagesReceived{0};
+            std::atomic<size_t> partialWrites{0};
+            std::atomic<size_t> residualCarryovers{0};
+            std::atomic<size_t> asyncReads{0};
+            std::atomic<size_t> speculativeReads{0};
+            std::atomic<size_t> errors{0};
+        };
+        Counters counters;
+        static void increment(std::atomic<size_t>& counter, size_t amount = 1)
+        {
+            counter.fetch_add(amount, std::memory_order_relaxed);
+        }
+        std::shared_ptr<LatencyHistograms> histograms;
+        /// the time the last read completed, only set if histograms is set
+        std::chrono::steady_clock::time_point readTime;
         std::shared_ptr<Socket> socket_;
         asio::io_context& context_;
         std::vector<char> data;
+        /// used in place of data if a mirrored buffer is requested
+        std::unique_ptr<MirroredBuffer> ringBuffer;
+        /// the capacity the receive buffer returns to after growing
+        size_t nominalBufferSize;
+        /// the limit on the receive buffer capacity
+        size_t maxBufferSize;
+        FramingMode framing{FramingMode::NONE};
         std::atomic<bool> triggerhalt{false};
+        /// set by pauseReceive until the receive loop has stopped
+        std::atomic<bool> pauseRequested{false};
+        std::mutex pauseLock;  //!< protects pauseCall
+        std::function<void(bool)> pauseCall;
         const bool connecting{false};
         gmlc::concurrency::TriggerVariable receivingHalt;
         std::atomic<bool> connectionError{false};
@@ -245,13 +699,44 @@ namespace networking {
                                                        //!< connectivity
         std::function<size_t(TcpConnection::pointer, const char*, size_t)>
             dataCall;
+        std::function<void(TcpConnection::pointer, const char*, size_t)>
+            messageCall;
         std::function<bool(TcpConnection::pointer, const std::error_code&)>
             errorCall;
+        /// set before connecting and cleared when it is called
+        ConnectCallback connectCall;
         std::function<void(int level, const std::string& logMessage)>
             logFunction;
+        std::function<void(
+            TcpConnection::pointer,
+            const std::error_code&,
+            size_t,
+            size_t)>
+            sendCompletionCall;
         std::atomic<ConnectionStates> state{ConnectionStates::PRESTART};
+        // sendQueue and sendActive are protected by the sendLock mutex
+        std::mutex sendLock;
+        std::deque<PendingSend> sendQueue;
+        /// true while a write (blocking or asynchronous) is in progress or
+        /// being started
+        bool sendActive{false};
+        /// only accessed by the thread holding the active write
+        std::vector<PendingSend> sendBatch;
+        std::atomic<size_t> pendingSends{0};
+        std::atomic<size_t> zeroCopyThreshold{0};
+        /// true from the start of an outgoing connection until it completes
+        std::atomic<bool> connectPending{false};
+        /// true while messages queued before the connection are written
+        std::atomic<bool> connectBacklog{false};
+        /// bytes queued while connectPending, protected by sendLock
+        size_t connectQueueBytes{0};
+        std::atomic<size_t> connectQueueLimit{defaultConnectQueueLimit};
         const int idcode;
         void connect_handler(const std::error_code& error);
+        /** finish an outgoing connection once the handshake completes*/
+        void handshake_handler(const std::error_code& error);
+        /** report a failed outgoing connection and fail the queued sends*/
+        void connectFailed(const std::error_code& error);
     };
 
 }  // namespace networking
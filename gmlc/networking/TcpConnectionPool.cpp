@@ -0,0 +1,418 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "TcpConnectionPool.h"
+
+#include "ResolutionCache.h"
+
+#include <algorithm>
+#include <asio/post.hpp>
+#include <future>
+#include <utility>
+
+namespace gmlc::networking {
+using asio::ip::tcp;
+
+/** the state of a checkout while it looks for a connection*/
+struct TcpConnectionPool::CheckoutRequest {
+    SocketFactory factory;
+    std::string settings;  //!< the settings key of the factory
+    std::string host;
+    std::string port;
+    std::chrono::milliseconds timeOut;
+    EstablishCallback callback;
+    ConnectionRetryPolicy policy;
+    std::vector<std::string> keys;  //!< the keys of the resolved endpoints
+};
+
+std::shared_ptr<TcpConnectionPool> TcpConnectionPool::create(
+    asio::io_context& io_context,
+    std::chrono::milliseconds idleTimeout,
+    size_t maxIdle)
+{
+    return std::shared_ptr<TcpConnectionPool>(
+        new TcpConnectionPool(io_context, idleTimeout, maxIdle));
+}
+
+TcpConnectionPool::~TcpConnectionPool()
+{
+    closeAll();
+}
+
+std::string TcpConnectionPool::makeKey(
+    const tcp::endpoint& endpoint,
+    const std::string& settings)
+{
+    std::string key = endpoint.address().to_string();
+    key.push_back('\n');
+    key.append(std::to_string(endpoint.port()));
+    key.push_back('\n');
+    key.append(settings);
+    return key;
+}
+
+void TcpConnectionPool::checkoutAsync(
+    const SocketFactory& sf,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    EstablishCallback callback,
+    const ConnectionRetryPolicy& policy)
+{
+    auto request = std::make_shared<CheckoutRequest>(CheckoutRequest{
+        sf,
+        sf.get_settings_key(),
+        host,
+        port,
+        timeOut,
+        std::move(callback),
+        policy,
+        {}});
+    // the callback is never called from inside the initiating call
+    asio::post(ioctx, [self = shared_from_this(), request]() {
+        ResolutionCache::instance()->asyncResolve(
+            self->ioctx,
+            tcp::v4(),
+            request->host,
+            request->port,
+            [self, request](
+                const std::error_code& ec,
+                const ResolutionCache::results_type& results) {
+                if (!ec) {
+                    for (const auto& result : results) {
+                        request->keys.push_back(
+                            makeKey(result.endpoint(), request->settings));
+                    }
+                }
+                // a failed resolution is reported by the new connection
+                self->nextIdle(request);
+            });
+    });
+}
+
+TcpConnection::pointer TcpConnectionPool::checkout(
+    const SocketFactory& sf,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy)
+{
+    using Outcome = std::pair<TcpConnection::pointer, std::error_code>;
+    auto promise = std::make_shared<std::promise<Outcome>>();
+    auto result = promise->get_future();
+    checkoutAsync(
+        sf,
+        host,
+        port,
+        timeOut,
+        [promise](
+            const TcpConnection::pointer& connection,
+            const std::error_code& error) {
+            promise->set_value(Outcome(connection, error));
+        },
+        policy);
+    auto outcome = result.get();
+    if (!outcome.first) {
+        throw std::system_error(
+            (outcome.second) ? outcome.second :
+                               make_error_code(asio::error::not_connected));
+    }
+    return outcome.first;
+}
+
+void TcpConnectionPool::nextIdle(
+    const std::shared_ptr<CheckoutRequest>& request)
+{
+    IdleConnection candidate;
+    std::string key;
+    {
+        std::lock_guard<std::mutex> poolLock(lock);
+        for (const auto& requestKey : request->keys) {
+            auto fnd = idle.find(requestKey);
+            if (fnd == idle.end()) {
+                continue;
+            }
+            // the most recently used connection is the least likely to have
+            // been closed by the server
+            candidate = std::move(fnd->second.back());
+            fnd->second.pop_back();
+            if (fnd->second.empty()) {
+                idle.erase(fnd);
+            }
+            key = requestKey;
+            break;
+        }
+    }
+    if (!candidate.connection) {
+        connectNew(request);
+        return;
+    }
+    if (candidate.stale->load() || !candidate.connection->isReceiving()) {
+        discard(candidate.connection);
+        nextIdle(request);
+        return;
+    }
+    auto connection = candidate.connection;
+    connection->pauseReceive([self = shared_from_this(),
+                              request,
+                              connection,
+                              stale = candidate.stale,
+                              key](bool paused) {
+        if (!paused || stale->load() ||
+            connection->getBufferedDataSize() > 0) {
+            self->discard(connection);
+            self->nextIdle(request);
+            return;
+        }
+        // the connection is handed out as if it were new
+        connection->setDataCall(nullptr);
+        connection->setErrorCall(nullptr);
+        self->handOut(request, connection, key, true);
+    });
+}
+
+void TcpConnectionPool::connectNew(
+    const std::shared_ptr<CheckoutRequest>& request)
+{
+    establishConnectionAsync(
+        request->factory,
+        ioctx,
+        request->host,
+        request->port,
+        request->timeOut,
+        [self = shared_from_this(), request](
+            const TcpConnection::pointer& connection,
+            const std::error_code& error) {
+            if (!connection) {
+                request->callback(nullptr, error);
+                return;
+            }
+            std::error_code ec;
+            auto remote = connection->socket()->remote_endpoint(ec);
+            // without the endpoint the connection can't be reused
+            self->handOut(
+                request,
+                connection,
+                (ec) ? std::string() : makeKey(remote, request->settings),
+                false);
+        },
+        request->policy);
+}
+
+void TcpConnectionPool::handOut(
+    const std::shared_ptr<CheckoutRequest>& request,
+    const TcpConnection::pointer& connection,
+    std::string key,
+    bool reused)
+{
+    {
+        std::lock_guard<std::mutex> poolLock(lock);
+        // connections closed without being checked in are forgotten here
+        for (auto it = checkedOut.begin(); it != checkedOut.end();) {
+            if (it->second.connection.expired()) {
+                it = checkedOut.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        checkedOut[connection->getIdentifier()] =
+            CheckedOut{connection, std::move(key)};
+        if (reused) {
+            ++stats.reused;
+        } else {
+            ++stats.created;
+        }
+    }
+    request->callback(connection, std::error_code());
+}
+
+bool TcpConnectionPool::checkin(const TcpConnection::pointer& connection)
+{
+    if (!connection) {
+        return false;
+    }
+    std::string key;
+    {
+        std::lock_guard<std::mutex> poolLock(lock);
+        auto fnd = checkedOut.find(connection->getIdentifier());
+        if (fnd == checkedOut.end() ||
+            fnd->second.connection.lock() != connection) {
+            return false;
+        }
+        key = std::move(fnd->second.key);
+        checkedOut.erase(fnd);
+    }
+    // pausing the receive loop would abort pending sends
+    if (key.empty() || !connection->isConnected() ||
+        !connection->socket()->is_open() ||
+        connection->getPendingSendCount() > 0) {
+        discard(connection);
+        return false;
+    }
+    connection->pauseReceive(
+        [pool = std::weak_ptr<TcpConnectionPool>(shared_from_this()),
+         connection,
+         key](bool paused) {
+            auto self = pool.lock();
+            if (self) {
+                self->keepIdle(connection, key, paused);
+            } else {
+                connection->closeNoWait();
+            }
+        });
+    return true;
+}
+
+void TcpConnectionPool::keepIdle(
+    const TcpConnection::pointer& connection,
+    const std::string& key,
+    bool paused)
+{
+    if (!paused || connection->getBufferedDataSize() > 0) {
+        discard(connection);
+        return;
+    }
+    // anything arriving while idle is either the server closing the
+    // connection or data no request is waiting for
+    auto stale = std::make_shared<std::atomic<bool>>(false);
+    connection->setFramingMode(FramingMode::NONE);
+    connection->setMessageCall(nullptr);
+    connection->setSendCompletionCall(nullptr);
+    connection->setDataCall(
+        [stale](const TcpConnection::pointer&, const char*, size_t datasize) {
+            stale->store(true);
+            return datasize;
+        });
+    connection->setErrorCall(
+        [stale](const TcpConnection::pointer&, const std::error_code&) {
+            stale->store(true);
+            return false;
+        });
+    connection->startReceive();
+
+    std::vector<TcpConnection::pointer> evicted;
+    {
+        std::lock_guard<std::mutex> poolLock(lock);
+        auto& connections = idle[key];
+        connections.push_back(IdleConnection{
+            connection, std::chrono::steady_clock::now(), std::move(stale)});
+        ++stats.returned;
+        while (connections.size() > maxIdle) {
+            evicted.push_back(std::move(connections.front().connection));
+            connections.pop_front();
+        }
+        if (connections.empty()) {
+            idle.erase(key);
+        }
+        stats.evicted += evicted.size();
+        armTimer();
+    }
+    for (auto& extra : evicted) {
+        extra->closeNoWait();
+    }
+}
+
+void TcpConnectionPool::discard(const TcpConnection::pointer& connection)
+{
+    connection->closeNoWait();
+    std::lock_guard<std::mutex> poolLock(lock);
+    ++stats.discarded;
+}
+
+void TcpConnectionPool::armTimer()
+{
+    if (timerArmed || idle.empty()) {
+        return;
+    }
+    // the connections in each list are in the order they were returned
+    auto oldest = idle.begin()->second.front().since;
+    for (const auto& connections : idle) {
+        oldest = (std::min)(oldest, connections.second.front().since);
+    }
+    timerArmed = true;
+    timer.expires_at(oldest + idleTimeout);
+    timer.async_wait(
+        [pool = std::weak_ptr<TcpConnectionPool>(shared_from_this())](
+            const std::error_code& error) {
+            auto self = pool.lock();
+            if (error || !self) {
+                return;
+            }
+            self->evictIdle();
+            std::lock_guard<std::mutex> poolLock(self->lock);
+            self->timerArmed = false;
+            self->armTimer();
+        });
+}
+
+size_t TcpConnectionPool::evictIdle()
+{
+    std::vector<TcpConnection::pointer> evicted;
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> poolLock(lock);
+        for (auto it = idle.begin(); it != idle.end();) {
+            auto& connections = it->second;
+            for (auto entry = connections.begin();
+                 entry != connections.end();) {
+                if (entry->since + idleTimeout <= now || entry->stale->load() ||
+                    !entry->connection->isReceiving()) {
+                    evicted.push_back(std::move(entry->connection));
+                    entry = connections.erase(entry);
+                } else {
+                    ++entry;
+                }
+            }
+            if (connections.empty()) {
+                it = idle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        stats.evicted += evicted.size();
+    }
+    for (auto& connection : evicted) {
+        connection->closeNoWait();
+    }
+    return evicted.size();
+}
+
+void TcpConnectionPool::closeAll()
+{
+    std::vector<TcpConnection::pointer> evicted;
+    {
+        std::lock_guard<std::mutex> poolLock(lock);
+        for (auto& connections : idle) {
+            for (auto& entry : connections.second) {
+                evicted.push_back(std::move(entry.connection));
+            }
+        }
+        idle.clear();
+        stats.evicted += evicted.size();
+    }
+    for (auto& connection : evicted) {
+        connection->closeNoWait();
+    }
+}
+
+size_t TcpConnectionPool::idleCount() const
+{
+    std::lock_guard<std::mutex> poolLock(lock);
+    size_t count{0};
+    for (const auto& connections : idle) {
+        count += connections.second.size();
+    }
+    return count;
+}
+
+TcpConnectionPool::Statistics TcpConnectionPool::getStatistics() const
+{
+    std::lock_guard<std::mutex> poolLock(lock);
+    return stats;
+}
+
+}  // namespace gmlc::networking
@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include "SocketFactory.h"
+#include "TcpConnection.h"
+#include "TcpOperations.h"
+
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace gmlc::networking {
+/** a pool of client connections reused by short lived requests
+@details idle connections are kept for each resolved endpoint and set of
+SocketFactory settings, so a request to a server that was used recently skips
+the TCP and TLS setup.  A checked out connection is in the same state as a new
+one from establishConnection, before startReceive, so the data, message and
+error callbacks and the framing mode are set as usual.  Other settings, such
+as the logging function, are kept from the previous use.  When a request is
+finished the connection is checked back in instead of being closed.
+
+While a connection is idle the pool runs its receive loop, so a connection
+closed by the peer or one that receives unexpected data is found and closed
+instead of being handed out again.  Idle connections are closed once they have
+been idle for the idle timeout.
+*/
+class TcpConnectionPool :
+    public std::enable_shared_from_this<TcpConnectionPool> {
+  public:
+    /** counts of what happened to the connections of a pool*/
+    struct Statistics {
+        size_t created{0};  //!< new connections checked out
+        size_t reused{0};  //!< idle connections checked out
+        size_t returned{0};  //!< connections checked in and kept
+        /// connections closed at checkin or checkout as not reusable
+        size_t discarded{0};
+        /// idle connections closed for the idle timeout, the idle limit, or
+        /// a failed health check
+        size_t evicted{0};
+    };
+    /// the default time a connection is kept idle
+    static constexpr std::chrono::milliseconds defaultIdleTimeout{30000};
+    /// the default limit on the idle connections to a single endpoint
+    static constexpr size_t defaultMaxIdle{8};
+
+    /** create a pool of connections on a context
+    @param io_context the context the connections are made on
+    @param idleTimeout the time a connection is kept idle before it is closed
+    @param maxIdle the most idle connections kept for an endpoint, the ones
+    idle the longest are closed first
+    */
+    static std::shared_ptr<TcpConnectionPool> create(
+        asio::io_context& io_context,
+        std::chrono::milliseconds idleTimeout = defaultIdleTimeout,
+        size_t maxIdle = defaultMaxIdle);
+    /** closes the idle connections*/
+    ~TcpConnectionPool();
+    TcpConnectionPool(const TcpConnectionPool&) = delete;
+    TcpConnectionPool& operator=(const TcpConnectionPool&) = delete;
+
+    /** get a connection to a server without blocking
+    @details an idle connection to one of the resolved endpoints of the host
+    made with the same SocketFactory settings is used if there is a healthy
+    one, otherwise a new connection is made as in establishConnectionAsync
+    @param[in] sf the SocketFactory to use for a new connection
+    @param[in] host the address of the server
+    @param[in] port the port number to connect to
+    @param[in] timeOut the time allowed for retries of a new connection
+    @param[in] callback called once from a thread running the context with
+    the connection, or with nullptr and the error that prevented it
+    @param[in] policy the delays between retries of a new connection
+    */
+    void checkoutAsync(
+        const SocketFactory& sf,
+        const std::string& host,
+        const std::string& port,
+        std::chrono::milliseconds timeOut,
+        EstablishCallback callback,
+        const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+    /** get a connection to a server and wait for it
+    @details must not be called from a thread running the context
+    @throws std::system_error if no connection could be made*/
+    TcpConnection::pointer checkout(
+        const SocketFactory& sf,
+        const std::string& host,
+        const std::string& port,
+        std::chrono::milliseconds timeOut,
+        const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+    /** get a connection to a server using the default SocketFactory and wait
+    for it
+    @throws std::system_error if no connection could be made*/
+    TcpConnection::pointer checkout(
+        const std::string& host,
+        const std::string& port,
+        std::chrono::milliseconds timeOut)
+    {
+        return checkout(SocketFactory(), host, port, timeOut);
+    }
+    /** return a connection to the pool once a request is finished
+    @details the receive loop is paused and the connection is kept if it is
+    still connected with no sends pending and no unconsumed data, otherwise it
+    is closed.  This can be called from inside a callback of the connection.
+    @return false if the connection was not checked out from this pool, or
+    was closed because it cannot be reused
+    */
+    bool checkin(const TcpConnection::pointer& connection);
+    /** close the idle connections past the idle timeout or that failed their
+    health check
+    @details this is also done by a timer on the context
+    @return the number of connections closed*/
+    size_t evictIdle();
+    /** close all the idle connections*/
+    void closeAll();
+    /** get the number of idle connections*/
+    size_t idleCount() const;
+    /** get the counts of what happened to the connections*/
+    Statistics getStatistics() const;
+    /** get the time a connection is kept idle*/
+    std::chrono::milliseconds getIdleTimeout() const { return idleTimeout; }
+
+  private:
+    /** a connection waiting in the pool*/
+    struct IdleConnection {
+        TcpConnection::pointer connection;
+        std::chrono::steady_clock::time_point since;
+        /// set if the connection received data or an error while idle
+        std::shared_ptr<std::atomic<bool>> stale;
+    };
+    /** a connection that is checked out*/
+    struct CheckedOut {
+        std::weak_ptr<TcpConnection> connection;
+        std::string key;  //!< empty if the endpoint was unknown
+    };
+    struct CheckoutRequest;
+
+    TcpConnectionPool(
+        asio::io_context& io_context,
+        std::chrono::milliseconds idle,
+        size_t maxIdleConnections) :
+        ioctx(io_context), idleTimeout(idle), maxIdle(maxIdleConnections),
+        timer(io_context)
+    {
+    }
+    /** make the key of the idle connections to an endpoint*/
+    static std::string makeKey(
+        const asio::ip::tcp::endpoint& endpoint,
+        const std::string& settings);
+    /** try the idle connections of the request in turn and make a new
+     * connection if none are usable*/
+    void nextIdle(const std::shared_ptr<CheckoutRequest>& request);
+    /** make a new connection for a request*/
+    void connectNew(const std::shared_ptr<CheckoutRequest>& request);
+    /** record a connection as checked out and hand it over*/
+    void handOut(
+        const std::shared_ptr<CheckoutRequest>& request,
+        const TcpConnection::pointer& connection,
+        std::string key,
+        bool reused);
+    /** keep a paused connection as idle or close it*/
+    void keepIdle(
+        const TcpConnection::pointer& connection,
+        const std::string& key,
+        bool paused);
+    /** close a connection that cannot be reused*/
+    void discard(const TcpConnection::pointer& connection);
+    /** wait for the oldest idle connection to expire, must be called with
+     * the lock held*/
+    void armTimer();
+
+    asio::io_context& ioctx;
+    const std::chrono::milliseconds idleTimeout;
+    const size_t maxIdle;
+    mutable std::mutex lock;  //!< protects everything below
+    asio::steady_timer timer;  //!< the wait for idle connections to expire
+    bool timerArmed{false};
+    /// the idle connections for each key, the most recently returned last
+    std::map<std::string, std::deque<IdleConnection>> idle;
+    /// the connections checked out by their identifier
+    std::map<int, CheckedOut> checkedOut;
+    Statistics stats;
+};
+}  // namespace gmlc::networking
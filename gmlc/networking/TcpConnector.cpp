@@ -0,0 +1,204 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "TcpConnector.h"
+
+#include <asio/post.hpp>
+#include <asio/strand.hpp>
+#include <utility>
+
+namespace gmlc::networking {
+using asio::ip::tcp;
+
+std::shared_ptr<TcpConnector> TcpConnector::create(
+    asio::io_context& io_context,
+    std::chrono::milliseconds attemptDelay)
+{
+    return create(asio::make_strand(io_context), attemptDelay);
+}
+
+std::shared_ptr<TcpConnector> TcpConnector::create(
+    const asio::any_io_executor& executor,
+    std::chrono::milliseconds attemptDelay)
+{
+    return std::shared_ptr<TcpConnector>(
+        new TcpConnector(executor, attemptDelay));
+}
+
+std::vector<tcp::endpoint>
+    TcpConnector::orderEndpoints(const std::vector<tcp::endpoint>& endpoints)
+{
+    if (endpoints.empty()) {
+        return {};
+    }
+    // keep the resolver preference within each family
+    const bool firstV6 = endpoints.front().address().is_v6();
+    std::vector<tcp::endpoint> preferred;
+    std::vector<tcp::endpoint> other;
+    for (const auto& endpoint : endpoints) {
+        if (endpoint.address().is_v6() == firstV6) {
+            preferred.push_back(endpoint);
+        } else {
+            other.push_back(endpoint);
+        }
+    }
+    std::vector<tcp::endpoint> result;
+    result.reserve(endpoints.size());
+    for (std::size_t ii = 0; ii < preferred.size() || ii < other.size(); ++ii) {
+        if (ii < preferred.size()) {
+            result.push_back(preferred[ii]);
+        }
+        if (ii < other.size()) {
+            result.push_back(other[ii]);
+        }
+    }
+    return result;
+}
+
+void TcpConnector::asyncConnect(
+    const std::vector<tcp::endpoint>& endpoints,
+    ConnectHandler connectHandler)
+{
+    std::error_code failure;
+    {
+        std::lock_guard<std::mutex> connectLock(lock);
+        if (started || done) {
+            failure = asio::error::operation_aborted;
+        } else if (endpoints.empty()) {
+            failure = asio::error::host_not_found;
+        }
+        started = true;
+        if (!failure) {
+            ordered = orderEndpoints(endpoints);
+            attempts.reserve(ordered.size());
+            handler = std::move(connectHandler);
+            startNext();
+            return;
+        }
+        done = true;
+    }
+    // the handler is never called from inside the initiating call
+    asio::post(
+        executor,
+        [self = shared_from_this(),
+         connectHandler = std::move(connectHandler),
+         failure]() {
+            connectHandler(failure, tcp::socket(self->executor));
+        });
+}
+
+void TcpConnector::startNext()
+{
+    if (attempts.size() >= ordered.size()) {
+        return;
+    }
+    const auto index = attempts.size();
+    attempts.push_back(std::make_unique<tcp::socket>(executor));
+    ++active;
+    attempts.back()->async_connect(
+        ordered[index],
+        [self = shared_from_this(), index](const std::error_code& error) {
+            self->attemptComplete(index, error);
+        });
+    if (attempts.size() < ordered.size()) {
+        // rearming the timer cancels the wait for the previous attempt
+        timer.expires_after(delay);
+        timer.async_wait(
+            [self = shared_from_this()](const std::error_code& error) {
+                if (error) {
+                    return;
+                }
+                std::lock_guard<std::mutex> connectLock(self->lock);
+                if (!self->done) {
+                    self->startNext();
+                }
+            });
+    }
+}
+
+void TcpConnector::attemptComplete(
+    std::size_t index,
+    const std::error_code& error)
+{
+    ConnectHandler finished;
+    std::unique_ptr<tcp::socket> winner;
+    std::error_code result;
+    {
+        std::lock_guard<std::mutex> connectLock(lock);
+        if (done) {
+            return;
+        }
+        --active;
+        if (!error) {
+            winner = std::move(attempts[index]);
+        } else {
+            lastError = error;
+            attempts[index].reset();
+            if (attempts.size() < ordered.size()) {
+                // a failed attempt starts the next one without waiting
+                startNext();
+                return;
+            }
+            if (active > 0) {
+                return;
+            }
+            result = lastError;
+        }
+        done = true;
+        closeAttempts();
+        timer.cancel();
+        finished = std::move(handler);
+    }
+    if (winner) {
+        finished(result, std::move(*winner));
+    } else {
+        finished(result, tcp::socket(executor));
+    }
+}
+
+void TcpConnector::cancel()
+{
+    ConnectHandler finished;
+    {
+        std::lock_guard<std::mutex> connectLock(lock);
+        if (done) {
+            return;
+        }
+        done = true;
+        closeAttempts();
+        timer.cancel();
+        finished = std::move(handler);
+    }
+    if (finished) {
+        // cancel can be called from a close so the handler is not run inline
+        asio::post(
+            executor,
+            [self = shared_from_this(), finished = std::move(finished)]() {
+                finished(
+                    asio::error::operation_aborted,
+                    tcp::socket(self->executor));
+            });
+    }
+}
+
+std::size_t TcpConnector::attemptCount() const
+{
+    std::lock_guard<std::mutex> connectLock(lock);
+    return attempts.size();
+}
+
+void TcpConnector::closeAttempts()
+{
+    std::error_code ec;
+    for (auto& attempt : attempts) {
+        if (attempt) {
+            attempt->close(ec);
+        }
+    }
+}
+
+}  // namespace gmlc::networking
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <asio/any_io_executor.hpp>
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/steady_timer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+namespace gmlc::networking {
+/** connect to the first reachable endpoint of a resolved host
+@details follows the "happy eyeballs" approach of RFC 8305: endpoints are
+ordered to alternate between address families and a new attempt is started
+each time the attempt delay passes without a connection, or immediately when
+an attempt fails.  The first attempt to connect wins and the others are
+closed, so an unreachable address costs the attempt delay instead of the
+operating system connect timeout.
+*/
+class TcpConnector : public std::enable_shared_from_this<TcpConnector> {
+  public:
+    using ConnectHandler =
+        std::function<void(const std::error_code&, asio::ip::tcp::socket)>;
+    /// the delay between attempts recommended by RFC 8305
+    static constexpr std::chrono::milliseconds defaultAttemptDelay{250};
+
+    /** create a connector running its handlers on a new strand of the
+     * io_context*/
+    static std::shared_ptr<TcpConnector> create(
+        asio::io_context& io_context,
+        std::chrono::milliseconds attemptDelay = defaultAttemptDelay);
+    /** create a connector running its handlers on an executor
+    @details the connected socket is created on the executor, it should be a
+    strand if several threads run the io_context*/
+    static std::shared_ptr<TcpConnector> create(
+        const asio::any_io_executor& executor,
+        std::chrono::milliseconds attemptDelay = defaultAttemptDelay);
+    TcpConnector(const TcpConnector&) = delete;
+    TcpConnector& operator=(const TcpConnector&) = delete;
+
+    /** order endpoints to alternate between address families starting with
+     * the family of the first endpoint*/
+    static std::vector<asio::ip::tcp::endpoint>
+        orderEndpoints(const std::vector<asio::ip::tcp::endpoint>& endpoints);
+
+    /** connect to one of the endpoints
+    @details the handler is called once, from the executor of the
+    connector, with the connected socket or with the error of the last
+    attempt if none succeeded.  A connector can only be used once.*/
+    void asyncConnect(
+        const std::vector<asio::ip::tcp::endpoint>& endpoints,
+        ConnectHandler handler);
+    /** stop connecting, the handler is called with operation_aborted if it
+     * has not been called yet*/
+    void cancel();
+    /** get the number of connection attempts that were started*/
+    std::size_t attemptCount() const;
+
+  private:
+    TcpConnector(
+        const asio::any_io_executor& ex,
+        std::chrono::milliseconds attemptDelay) :
+        executor(ex), timer(ex), delay(attemptDelay)
+    {
+    }
+    /** start the next attempt and wait for the attempt delay if there are
+     * more, must be called with the lock held*/
+    void startNext();
+    void attemptComplete(std::size_t index, const std::error_code& error);
+    /** close the attempts still in progress, must be called with the lock
+     * held*/
+    void closeAttempts();
+
+    asio::any_io_executor executor;  //!< runs the attempts and the timer
+    asio::steady_timer timer;  //!< the delay before the next attempt
+    const std::chrono::milliseconds delay;
+    mutable std::mutex lock;  //!< protects everything below
+    std::vector<asio::ip::tcp::endpoint> ordered;
+    std::vector<std::unique_ptr<asio::ip::tcp::socket>> attempts;
+    std::size_t active{0};  //!< attempts still in progress
+    bool started{false};
+    bool done{false};  //!< the handler has been called or scheduled
+    std::error_code lastError;
+    ConnectHandler handler;
+};
+}  // namespace gmlc::networking
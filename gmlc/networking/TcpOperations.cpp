@@ -7,12 +7,21 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 #include "TcpOperations.h"
 
 #include "AsioContextManager.h"
+#include "AsioContextPool.h"
 
 #include "TcpHelperClasses.h"
 #include "addressOperations.hpp"
+#include <algorithm>
+#include <asio/steady_timer.hpp>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace gmlc::networking {
 
@@ -91,4 +100,360 @@ TcpConnection::pointer establishConnection(
     std::tie(interface, port) = extractInterfaceAndPortString(address);
     return establishConnection(sf, io_context, interface, port, timeOut);
 }
+namespace {
+    /** makes connection attempts on a context until one connects or the time
+     * for retries runs out*/
+    class ConnectionEstablisher :
+        public std::enable_shared_from_this<ConnectionEstablisher> {
+      public:
+        ConnectionEstablisher(
+            const SocketFactory& sf,
+            asio::io_context& io_context,
+            std::string hostName,
+            std::string portName,
+            std::chrono::milliseconds timeOut,
+            EstablishCallback establishCall,
+            const ConnectionRetryPolicy& retryPolicy) :
+            factory(sf),
+            ioctx(io_context), host(std::move(hostName)),
+            port(std::move(portName)),
+            deadline(std::chrono::steady_clock::now() + timeOut),
+            retry(timeOut > std::chrono::milliseconds(0)),
+            callback(std::move(establishCall)), policy(retryPolicy),
+            retryTimer(io_context), attemptTimer(io_context),
+            delay(retryPolicy.initialDelay), generator(std::random_device{}())
+        {
+        }
+
+        /** start a connection attempt*/
+        void attempt()
+        {
+            // the lock is held until the attempt is recorded so its
+            // completion, which never runs inside create, finds it
+            std::lock_guard<std::mutex> establishLock(lock);
+            if (finished) {
+                return;
+            }
+            auto connection = TcpConnection::create(
+                factory,
+                ioctx,
+                host,
+                port,
+                [self = shared_from_this()](
+                    const TcpConnection::pointer& conn,
+                    const std::error_code& error) {
+                    self->attemptComplete(conn, error);
+                });
+            current = connection;
+            auto limit = policy.attemptTimeout;
+            if (retry) {
+                limit = std::min(
+                    limit,
+                    std::chrono::ceil<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()));
+            }
+            attemptTimer.expires_after(limit);
+            attemptTimer.async_wait(
+                [self = shared_from_this(),
+                 attempted = std::weak_ptr<TcpConnection>(connection)](
+                    const std::error_code& error) {
+                    if (!error) {
+                        self->attemptExpired(attempted.lock());
+                    }
+                });
+        }
+
+      private:
+        void attemptComplete(
+            const TcpConnection::pointer& connection,
+            const std::error_code& error)
+        {
+            EstablishCallback finishCall;
+            std::error_code result;
+            {
+                std::lock_guard<std::mutex> establishLock(lock);
+                if (finished || connection != current) {
+                    // an abandoned attempt
+                    return;
+                }
+                current.reset();
+                attemptTimer.cancel();
+                if (error) {
+                    lastError = error;
+                    if (!scheduleRetry()) {
+                        return;
+                    }
+                    result = lastError;
+                } else {
+                    finished = true;
+                }
+                finishCall = std::move(callback);
+            }
+            if (result) {
+                finishCall(nullptr, result);
+            } else {
+                finishCall(connection, result);
+            }
+        }
+
+        void attemptExpired(const TcpConnection::pointer& connection)
+        {
+            EstablishCallback finishCall;
+            {
+                std::lock_guard<std::mutex> establishLock(lock);
+                if (finished || !connection || connection != current) {
+                    return;
+                }
+                // the attempt is abandoned before closing it so its
+                // completion is ignored
+                current.reset();
+                lastError = asio::error::timed_out;
+                if (scheduleRetry()) {
+                    finishCall = std::move(callback);
+                }
+            }
+            connection->closeNoWait();
+            if (finishCall) {
+                finishCall(nullptr, asio::error::timed_out);
+            }
+        }
+
+        /** wait before the next attempt, must be called with the lock held
+        @return true if no more attempts are made*/
+        bool scheduleRetry()
+        {
+            const auto wait = nextDelay();
+            if (!retry || std::chrono::steady_clock::now() + wait >= deadline) {
+                finished = true;
+                return true;
+            }
+            retryTimer.expires_after(wait);
+            retryTimer.async_wait(
+                [self = shared_from_this()](const std::error_code& error) {
+                    if (!error) {
+                        self->attempt();
+                    }
+                });
+            return false;
+        }
+
+        /** get the jittered delay before the next attempt and grow the
+         * delay for the one after*/
+        std::chrono::milliseconds nextDelay()
+        {
+            const auto base = delay;
+            delay = std::min(
+                policy.maxDelay,
+                std::chrono::milliseconds(static_cast<std::int64_t>(
+                    static_cast<double>(delay.count()) * policy.multiplier)));
+            std::uniform_real_distribution<double> removed(
+                0.0, std::clamp(policy.jitter, 0.0, 1.0));
+            return std::chrono::milliseconds(static_cast<std::int64_t>(
+                static_cast<double>(base.count()) *
+                (1.0 - removed(generator))));
+        }
+
+        const SocketFactory factory;
+        asio::io_context& ioctx;
+        const std::string host;
+        const std::string port;
+        const std::chrono::steady_clock::time_point deadline;
+        const bool retry;
+        EstablishCallback callback;
+        const ConnectionRetryPolicy policy;
+        std::mutex lock;  //!< protects everything below
+        asio::steady_timer retryTimer;
+        asio::steady_timer attemptTimer;
+        std::chrono::milliseconds delay;
+        std::mt19937 generator;
+        TcpConnection::pointer current;  //!< the attempt in progress
+        std::error_code lastError;
+        bool finished{false};
+    };
+}  // namespace
+
+void establishConnectionAsync(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    EstablishCallback callback,
+    const ConnectionRetryPolicy& policy)
+{
+    auto establisher = std::make_shared<ConnectionEstablisher>(
+        sf, io_context, host, port, timeOut, std::move(callback), policy);
+    establisher->attempt();
+}
+
+std::future<TcpConnection::pointer> establishConnectionAsync(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy)
+{
+    auto promise = std::make_shared<std::promise<TcpConnection::pointer>>();
+    auto result = promise->get_future();
+    establishConnectionAsync(
+        sf,
+        io_context,
+        host,
+        port,
+        timeOut,
+        [promise](
+            const TcpConnection::pointer& connection, const std::error_code&) {
+            promise->set_value(connection);
+        },
+        policy);
+    return result;
+}
+
+std::future<TcpConnection::pointer> establishConnectionAsync(
+    asio::io_context& io_context,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy)
+{
+    return establishConnectionAsync(
+        SocketFactory(), io_context, host, port, timeOut, policy);
+}
+namespace {
+    /** the results of a group of connections filled in as they complete*/
+    struct EstablishGroup {
+        std::mutex lock;  //!< protects everything below
+        std::vector<EstablishResult> results;
+        std::size_t remaining{0};
+        EstablishGroupCallback callback;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void establishGroup(
+        const SocketFactory& sf,
+        const std::function<asio::io_context&()>& nextContext,
+        const std::vector<std::string>& addresses,
+        std::chrono::milliseconds timeOut,
+        EstablishGroupCallback callback,
+        const ConnectionRetryPolicy& policy)
+    {
+        if (addresses.empty()) {
+            callback({});
+            return;
+        }
+        auto group = std::make_shared<EstablishGroup>();
+        group->results.resize(addresses.size());
+        for (std::size_t ii = 0; ii < addresses.size(); ++ii) {
+            group->results[ii].address = addresses[ii];
+        }
+        group->remaining = addresses.size();
+        group->callback = std::move(callback);
+        group->start = std::chrono::steady_clock::now();
+        // all the connections share the deadline since they start together
+        for (std::size_t ii = 0; ii < addresses.size(); ++ii) {
+            std::string host;
+            std::string port;
+            std::tie(host, port) = extractInterfaceAndPortString(addresses[ii]);
+            establishConnectionAsync(
+                sf,
+                nextContext(),
+                host,
+                port,
+                timeOut,
+                [group, ii](
+                    const TcpConnection::pointer& connection,
+                    const std::error_code& error) {
+                    EstablishGroupCallback finished;
+                    {
+                        std::lock_guard<std::mutex> groupLock(group->lock);
+                        auto& result = group->results[ii];
+                        result.connection = connection;
+                        result.error = error;
+                        result.elapsed = std::chrono::duration_cast<
+                            std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - group->start);
+                        if (--group->remaining > 0) {
+                            return;
+                        }
+                        finished = std::move(group->callback);
+                    }
+                    finished(std::move(group->results));
+                },
+                policy);
+        }
+    }
+
+    std::vector<EstablishResult> waitForGroup(
+        const std::function<void(EstablishGroupCallback)>& start)
+    {
+        auto promise =
+            std::make_shared<std::promise<std::vector<EstablishResult>>>();
+        auto result = promise->get_future();
+        start([promise](std::vector<EstablishResult> results) {
+            promise->set_value(std::move(results));
+        });
+        return result.get();
+    }
+}  // namespace
+
+void establishConnectionsAsync(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    EstablishGroupCallback callback,
+    const ConnectionRetryPolicy& policy)
+{
+    establishGroup(
+        sf,
+        [&io_context]() -> asio::io_context& { return io_context; },
+        addresses,
+        timeOut,
+        std::move(callback),
+        policy);
+}
+
+void establishConnectionsAsync(
+    const SocketFactory& sf,
+    AsioContextPool& pool,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    EstablishGroupCallback callback,
+    const ConnectionRetryPolicy& policy)
+{
+    establishGroup(
+        sf,
+        [&pool]() -> asio::io_context& { return pool.nextContext(); },
+        addresses,
+        timeOut,
+        std::move(callback),
+        policy);
+}
+
+std::vector<EstablishResult> establishConnections(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy)
+{
+    return waitForGroup([&](EstablishGroupCallback callback) {
+        establishConnectionsAsync(
+            sf, io_context, addresses, timeOut, std::move(callback), policy);
+    });
+}
+
+std::vector<EstablishResult> establishConnections(
+    const SocketFactory& sf,
+    AsioContextPool& pool,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy)
+{
+    return waitForGroup([&](EstablishGroupCallback callback) {
+        establishConnectionsAsync(
+            sf, pool, addresses, timeOut, std::move(callback), policy);
+    });
+}
 }  // namespace gmlc::networking
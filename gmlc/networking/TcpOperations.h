@@ -13,8 +13,12 @@ TCP comms */
 #include "TcpHelperClasses.h"
 
 #include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <system_error>
+#include <vector>
 
 class AsioContextManager;
 namespace asio {
@@ -22,6 +26,7 @@ class io_context;
 }  // namespace asio
 
 namespace gmlc::networking {
+class AsioContextPool;
 
 /** establish a connection to a server by as associated optional timeout
 @param[in] io_context the context to establish the connection
@@ -81,4 +86,127 @@ TcpConnection::pointer establishConnection(
     const std::string& address,
     std::chrono::milliseconds timeOut = std::chrono::milliseconds(0));
 
+/** how establishConnectionAsync retries a connection
+@details the delay before each retry grows from the initial delay by the
+multiplier up to the maximum delay, and a random part of it set by the jitter
+fraction is removed so many clients started together do not retry in step*/
+struct ConnectionRetryPolicy {
+    std::chrono::milliseconds initialDelay{std::chrono::milliseconds(50)};
+    std::chrono::milliseconds maxDelay{std::chrono::milliseconds(2000)};
+    double multiplier{2.0};
+    /// the largest fraction of a delay that is randomly removed, 0 to 1
+    double jitter{0.5};
+    /// the time a single attempt may take before it is abandoned
+    std::chrono::milliseconds attemptTimeout{std::chrono::milliseconds(5000)};
+};
+
+/// callback with the connection or the error that ended the attempts
+using EstablishCallback =
+    std::function<void(const TcpConnection::pointer&, const std::error_code&)>;
+
+/** establish a connection to a server without blocking
+@details attempts are made and retried on the io_context with timers until
+one connects or the timeout passes, no thread is blocked while waiting
+@param[in] sf the SocketFactory to use for creating the socket
+@param[in] io_context the context to establish the connection
+@param[in] host the address of the connection to establish
+@param[in] port the port number to connect to
+@param[in] timeOut the time allowed for retries, if <=0 a single attempt is
+made
+@param[in] callback called once with the connected connection, or with
+nullptr and the error of the last attempt
+@param[in] policy the delays between retries
+*/
+void establishConnectionAsync(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    EstablishCallback callback,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
+/** establish a connection to a server without blocking
+@return a future for the connection, nullptr if no attempt connected*/
+std::future<TcpConnection::pointer> establishConnectionAsync(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
+/** establish a connection to a server without blocking using the default
+SocketFactory
+@return a future for the connection, nullptr if no attempt connected*/
+std::future<TcpConnection::pointer> establishConnectionAsync(
+    asio::io_context& io_context,
+    const std::string& host,
+    const std::string& port,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
+/** the outcome of establishing one of a group of connections*/
+struct EstablishResult {
+    std::string address;  //!< the address as it was given
+    TcpConnection::pointer connection;  //!< nullptr if no attempt connected
+    std::error_code error;  //!< the error of the last attempt
+    /// the time from the start of the group until the outcome was known
+    std::chrono::milliseconds elapsed{0};
+};
+
+/// callback with the results of a group in the order of the addresses
+using EstablishGroupCallback =
+    std::function<void(std::vector<EstablishResult>)>;
+
+/** establish connections to many servers at once without blocking
+@details every connection is attempted and retried concurrently as in
+establishConnectionAsync, so the time taken is set by the slowest server
+rather than the sum of them
+@param[in] sf the SocketFactory to use for creating the sockets
+@param[in] io_context the context to establish the connections on
+@param[in] addresses the network address:port of each server
+@param[in] timeOut the deadline for all the connections
+@param[in] callback called once when every connection has an outcome
+@param[in] policy the delays between retries of each connection
+*/
+void establishConnectionsAsync(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    EstablishGroupCallback callback,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
+/** establish connections to many servers at once spread over the contexts
+of a pool without blocking*/
+void establishConnectionsAsync(
+    const SocketFactory& sf,
+    AsioContextPool& pool,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    EstablishGroupCallback callback,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
+/** establish connections to many servers at once and wait for them
+@details must not be called from a thread running the context
+@return the results in the order of the addresses*/
+std::vector<EstablishResult> establishConnections(
+    const SocketFactory& sf,
+    asio::io_context& io_context,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
+/** establish connections to many servers at once spread over the contexts
+of a pool and wait for them
+@details must not be called from a thread running one of the contexts
+@return the results in the order of the addresses*/
+std::vector<EstablishResult> establishConnections(
+    const SocketFactory& sf,
+    AsioContextPool& pool,
+    const std::vector<std::string>& addresses,
+    std::chrono::milliseconds timeOut,
+    const ConnectionRetryPolicy& policy = ConnectionRetryPolicy());
+
 }  // namespace gmlc::networking
@@ -7,9 +7,12 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include "TcpServer.h"
 
+#include "ResolutionCache.h"
+
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <system_error>
 #include <thread>
 #include <utility>
 
@@ -48,13 +51,17 @@ TcpServer::TcpServer(
     } else if (address == "localhost") {
         endpoints.emplace_back(asio::ip::tcp::v4(), portNum);
     } else {
-        tcp::resolver resolver(io_context);
-
-        auto results = resolver.resolve(
+        std::error_code ec;
+        auto results = ResolutionCache::instance()->resolve(
+            io_context,
             tcp::v4(),
             address,
             std::to_string(portNum),
+            ec,
             tcp::resolver::canonical_name);
+        if (ec) {
+            throw std::system_error(ec);
+        }
 
         if (!results.empty()) {
             for (auto& res : results) {
@@ -93,9 +100,17 @@ TcpServer::TcpServer(
     ioctx(io_context), socket_factory(sf), bufferSize(nominalBufferSize),
     reuse_address(port_reuse)
 {
-    tcp::resolver resolver(io_context);
-    tcp::resolver::results_type results = resolver.resolve(
-        tcp::v4(), address, port, tcp::resolver::canonical_name);
+    std::error_code ec;
+    auto results = ResolutionCache::instance()->resolve(
+        io_context,
+        tcp::v4(),
+        address,
+        port,
+        ec,
+        tcp::resolver::canonical_name);
+    if (ec) {
+        throw std::system_error(ec);
+    }
     if (!results.empty()) {
         for (auto& res : results) {
             endpoints.push_back(res);
@@ -144,21 +159,43 @@ void TcpServer::initialConnect()
         logger(0, "previously halted server");
         return;
     }
+    const bool sharded =
+        (contextPool && poolMode == PoolMode::SHARDED_ACCEPTORS);
+    const size_t shards = (sharded) ? contextPool->size() : 1;
     for (auto& ep : endpoints) {
-        auto acc = TcpAcceptor::create(ioctx, ep);
-        if (reuse_address) {
-            acc->set_option(tcp::acceptor::reuse_address(true));
-        } else {
-            acc->set_option(tcp::acceptor::reuse_address(false));
-        }
-        acc->setAcceptCall(
-            [this](TcpAcceptor::pointer accPtr, TcpConnection::pointer conn) {
-                handle_accept(std::move(accPtr), std::move(conn));
+        for (size_t shard = 0; shard < shards; ++shard) {
+            auto acc = TcpAcceptor::create(
+                (sharded) ? contextPool->getContext(shard) : ioctx, ep);
+            if (reuse_address) {
+                acc->set_option(tcp::acceptor::reuse_address(true));
+            } else {
+                acc->set_option(tcp::acceptor::reuse_address(false));
+            }
+            if (sharded && !acc->set_reuse_port(true)) {
+                logger(
+                    0,
+                    "SO_REUSEPORT is not available, connections are shared "
+                    "round robin instead");
+                poolMode = PoolMode::ROUND_ROBIN;
+                acceptors.clear();
+                initialConnect();
+                return;
+            }
+            acc->setListenBacklog(listenBacklog);
+            acc->setPendingAccepts(pendingAccepts);
+            acc->setConnectionFactory([this](const TcpAcceptor& acceptor) {
+                return newConnection(acceptor);
             });
-        if (logFunction) {
-            acc->setLoggingFunction(logFunction);
+            acc->setAcceptCall(
+                [this](
+                    TcpAcceptor::pointer accPtr, TcpConnection::pointer conn) {
+                    handle_accept(std::move(accPtr), std::move(conn));
+                });
+            if (logFunction) {
+                acc->setLoggingFunction(logFunction);
+            }
+            acceptors.push_back(std::move(acc));
         }
-        acceptors.push_back(std::move(acc));
     }
     bool anyConnect = false;
     size_t connectedAcceptors = 0;
@@ -310,20 +347,17 @@ bool TcpServer::start()
         }
     }
 
-    {  // scope for the lock_guard
-        std::lock_guard<std::mutex> lock(accepting);
-        if (!connections.empty()) {
-            for (auto& conn : connections) {
-                if (!conn->isReceiving()) {
-                    conn->startReceive();
-                }
+    {  // scope for the lock handle
+        auto table = connections.lock_shared();
+        for (const auto& entry : *table) {
+            if (!entry.second->isReceiving()) {
+                entry.second->startReceive();
             }
         }
     }
     bool success = true;
     for (auto& acc : acceptors) {
-        if (!acc->start(
-                TcpConnection::create(socket_factory, ioctx, bufferSize))) {
+        if (!acc->start()) {
             logger(0, "acceptor has failed to start");
             success = false;
         }
@@ -332,9 +366,10 @@ bool TcpServer::start()
 }
 
 void TcpServer::handle_accept(
-    TcpAcceptor::pointer acc,
+    TcpAcceptor::pointer /*acc*/,
     TcpConnection::pointer new_connection)
 {
+    // the acceptor has already started the next accept
     /*setting linger to 1 second*/
     new_connection->socket()->set_option_linger(true, 0);
     new_connection->socket()->set_option_no_delay(true);
@@ -345,43 +380,159 @@ void TcpServer::handle_accept(
     }
 
     new_connection->setHandshakeModeServer();
-    new_connection->handshake();
+    // the connection only starts receiving once the handshake is done, the
+    // handshake runs asynchronously so it does not hold up the context
+    new_connection->asyncHandshake(
+        [server = weak_from_this(),
+         new_connection](const std::error_code& error) {
+            auto self = server.lock();
+            if (!self) {
+                new_connection->close();
+                return;
+            }
+            if (error) {
+                if (error != asio::error::operation_aborted) {
+                    self->logger(
+                        0, std::string("handshake error ") + error.message());
+                }
+                new_connection->close();
+                return;
+            }
+            self->completeAccept(new_connection);
+        });
+}
 
+void TcpServer::completeAccept(const TcpConnection::pointer& new_connection)
+{
+    if (halted.load()) {
+        new_connection->close();
+        return;
+    }
+    new_connection->setReceiveBufferMode(receiveMode);
+    new_connection->setMaxBufferSize(maxBufferSize);
+    if (zeroCopyThreshold > 0) {
+        new_connection->setZeroCopyThreshold(zeroCopyThreshold);
+    }
+    new_connection->setReadBudget(readBudget);
+    new_connection->setFramingMode(framing);
+    new_connection->setLatencyHistograms(histograms);
+    new_connection->setMessageCall(messageCall);
     new_connection->setDataCall(dataCall);
     new_connection->setErrorCall(errorCall);
     if (logFunction) {
         new_connection->setLoggingFunction(logFunction);
     }
     new_connection->startReceive();
-    {  // scope for the lock_guard
-
-        std::unique_lock<std::mutex> lock(accepting);
+    bool added{false};
+    {  // scope for the lock handle
+        auto table = connections.lock();
         if (!halted.load()) {
-            connections.push_back(std::move(new_connection));
-        } else {
-            lock.unlock();
-            new_connection->close();
-            return;
+            table->emplace(new_connection->getIdentifier(), new_connection);
+            added = true;
         }
     }
-    acc->start(TcpConnection::create(socket_factory, ioctx, bufferSize));
+    if (!added) {
+        new_connection->close();
+    }
+}
+
+void TcpServer::setContextPool(
+    std::shared_ptr<AsioContextPool> pool,
+    PoolMode mode)
+{
+    const bool wasSharded =
+        (contextPool && poolMode == PoolMode::SHARDED_ACCEPTORS);
+    contextPool = std::move(pool);
+    poolMode = mode;
+    const bool sharded =
+        (contextPool && poolMode == PoolMode::SHARDED_ACCEPTORS);
+    if ((sharded || wasSharded) && !halted.load()) {
+        // the acceptors are bound when the server is created so they are
+        // replaced with ones on the new contexts
+        for (auto& acc : acceptors) {
+            acc->close();
+        }
+        acceptors.clear();
+        initialConnect();
+    }
+}
+
+void TcpServer::setListenBacklog(int backlog)
+{
+    listenBacklog = backlog;
+    for (auto& acc : acceptors) {
+        acc->setListenBacklog(backlog);
+    }
+}
+
+void TcpServer::setPendingAccepts(int count)
+{
+    pendingAccepts = count;
+    for (auto& acc : acceptors) {
+        acc->setPendingAccepts(count);
+    }
+}
+
+TcpConnection::pointer TcpServer::newConnection(const TcpAcceptor& acc)
+{
+    if (!contextPool) {
+        return TcpConnection::create(socket_factory, ioctx, bufferSize);
+    }
+    auto& context = (poolMode == PoolMode::SHARDED_ACCEPTORS) ?
+        acc.getContext() :
+        contextPool->nextContext();
+    return TcpConnection::create(socket_factory, context, bufferSize);
 }
 
 TcpConnection::pointer TcpServer::findSocket(int connectorID) const
 {
-    std::unique_lock<std::mutex> lock(accepting);
-    auto ptr = std::find_if(
-        connections.begin(),
-        connections.end(),
-        [connectorID](const auto& conn) {
-            return (conn->getIdentifier() == connectorID);
-        });
-    if (ptr != connections.end()) {
-        return *ptr;
+    auto table = connections.lock_shared();
+    auto fnd = table->find(connectorID);
+    if (fnd != table->end()) {
+        return fnd->second;
     }
     return nullptr;
 }
 
+std::vector<TcpConnection::pointer> TcpServer::takeConnections()
+{
+    std::vector<TcpConnection::pointer> taken;
+    auto table = connections.lock();
+    taken.reserve(table->size());
+    for (auto& entry : *table) {
+        taken.push_back(std::move(entry.second));
+    }
+    table->clear();
+    return taken;
+}
+
+TcpConnection::Statistics TcpServer::getStatistics() const
+{
+    TcpConnection::Statistics total;
+    auto table = connections.lock_shared();
+    for (const auto& entry : *table) {
+        total += entry.second->getStatistics();
+    }
+    return total;
+}
+
+std::vector<std::pair<int, TcpConnection::Statistics>>
+    TcpServer::getConnectionStatistics() const
+{
+    std::vector<std::pair<int, TcpConnection::Statistics>> stats;
+    {
+        auto table = connections.lock_shared();
+        stats.reserve(table->size());
+        for (const auto& entry : *table) {
+            stats.emplace_back(entry.first, entry.second->getStatistics());
+        }
+    }
+    std::sort(stats.begin(), stats.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return stats;
+}
+
 void TcpServer::close()
 {
     halted = true;
@@ -398,18 +549,41 @@ void TcpServer::close()
         acceptors.clear();
     }
 
-    std::unique_lock<std::mutex> lock(accepting);
-    auto sz = connections.size();
-    lock.unlock();
-    if (sz > 0) {
-        for (decltype(sz) ii = 0; ii < sz; ++ii) {
-            connections[ii]->closeNoWait();
-        }
-        for (decltype(sz) ii = 0; ii < sz; ++ii) {
-            connections[ii]->waitOnClose();
+    auto closing = takeConnections();
+    for (auto& conn : closing) {
+        conn->closeNoWait();
+    }
+    for (auto& conn : closing) {
+        conn->waitOnClose();
+    }
+}
+
+TcpServer::CloseSummary
+    TcpServer::closeAll(std::chrono::steady_clock::time_point deadline)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto closing = takeConnections();
+    for (auto& conn : closing) {
+        conn->closeNoWait();
+    }
+    CloseSummary summary;
+    for (auto& conn : closing) {
+        if (conn->waitOnClose(deadline)) {
+            ++summary.closed;
+        } else {
+            ++summary.timedOut;
         }
-        connections.clear();
     }
+    summary.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (summary.timedOut > 0) {
+        logger(
+            1,
+            std::to_string(summary.timedOut) + " of " +
+                std::to_string(closing.size()) +
+                " connections did not close before the deadline");
+    }
+    return summary;
 }
 
 void TcpServer::logger(int logLevel, const std::string& message)
@@ -6,6 +6,7 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 */
 #pragma once
 
+#include "AsioContextPool.h"
 #include "SocketFactory.h"
 #include "TcpAcceptor.h"
 #include "TcpConnection.h"
@@ -15,9 +16,12 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,6 +35,8 @@ namespace gmlc::networking {
 class TcpServer : public std::enable_shared_from_this<TcpServer> {
   public:
     using pointer = std::shared_ptr<TcpServer>;
+    /// the number of accepts each acceptor keeps pending by default
+    static constexpr int defaultPendingAccepts{4};
 
     static pointer create(
         asio::io_context& io_context,
@@ -71,6 +77,18 @@ class TcpServer : public std::enable_shared_from_this<TcpServer> {
         int nominalBufferSize = 10192);
 
   public:
+    /** the ways a server can use a pool of contexts*/
+    enum class PoolMode {
+        ROUND_ROBIN = 0,  //!< connections are handed out in turn
+        SHARDED_ACCEPTORS = 1,  //!< an acceptor on every context
+    };
+    /** the result of closing all the connections of a server*/
+    struct CloseSummary {
+        size_t closed{0};  //!< connections that finished closing
+        /// connections still waiting on a read handler at the deadline
+        size_t timedOut{0};
+        std::chrono::milliseconds elapsed{0};  //!< time taken to close
+    };
     ~TcpServer();
     /**set the port reuse flag */
     void setPortReuse(bool reuse) { reuse_address = reuse; }
@@ -79,6 +97,13 @@ class TcpServer : public std::enable_shared_from_this<TcpServer> {
     bool start();
     /** close the server*/
     void close();
+    /** close all current connections and wait for them until a deadline
+    @details every connection is told to close before waiting on any of them
+    so the total time is bounded by the slowest connection rather than the
+    sum.  The server keeps accepting new connections.  Connections that have
+    not finished by the deadline are released and complete on their own.
+    */
+    CloseSummary closeAll(std::chrono::steady_clock::time_point deadline);
     /** check if the server is ready to start*/
     bool isReady() const { return !(halted.load()); }
     /** reConnect the server with the same address*/
@@ -97,6 +122,68 @@ class TcpServer : public std::enable_shared_from_this<TcpServer> {
     {
         errorCall = std::move(errorFunc);
     }
+    /** set the type of receive buffer used by accepted connections*/
+    void setReceiveBufferMode(TcpConnection::ReceiveBufferMode mode)
+    {
+        receiveMode = mode;
+    }
+    /** set the maximum size the receive buffer of accepted connections can
+     * grow to
+     * @throws std::runtime_error if the size is 0*/
+    void setMaxBufferSize(size_t maxSize)
+    {
+        if (maxSize == 0) {
+            throw(std::runtime_error(
+                "the buffer limit must be greater than 0"));
+        }
+        maxBufferSize = maxSize;
+    }
+    /** set the minimum size of queued sends on accepted connections that are
+     * sent without copying, 0 to disable*/
+    void setZeroCopyThreshold(size_t threshold)
+    {
+        zeroCopyThreshold = threshold;
+    }
+    /** set the number of non-blocking reads accepted connections attempt
+     * after each read completes*/
+    void setReadBudget(size_t budget) { readBudget = budget; }
+    /** set the length header format used by accepted connections*/
+    void setFramingMode(FramingMode mode) { framing = mode; }
+    /** set the histograms accepted connections record latencies in
+    @details all accepted connections share the histograms, null to disable*/
+    void setLatencyHistograms(
+        std::shared_ptr<LatencyHistograms> latencyHistograms)
+    {
+        histograms = std::move(latencyHistograms);
+    }
+    /** spread accepted connections over the contexts of a pool
+    @details in ROUND_ROBIN mode each new connection is created on the next
+    context of the pool in turn while the acceptors stay on the context of the
+    server.  In SHARDED_ACCEPTORS mode every context gets its own acceptor for
+    each endpoint, bound with SO_REUSEPORT so the kernel balances incoming
+    connections between them, and each connection stays on the context that
+    accepted it.  If SO_REUSEPORT is not available ROUND_ROBIN is used.  Must
+    be called before start.
+    */
+    void setContextPool(
+        std::shared_ptr<AsioContextPool> pool,
+        PoolMode mode = PoolMode::ROUND_ROBIN);
+    /** set the backlog of the listen queue of each acceptor, must be called
+     * before start*/
+    void setListenBacklog(int backlog);
+    /** set the number of accepts each acceptor keeps pending at once
+    @details a burst of incoming connections is accepted without waiting for
+    the setup of the previous connection to finish*/
+    void setPendingAccepts(int count);
+    /** get the number of acceptors listening for connections*/
+    size_t getAcceptorCount() const { return acceptors.size(); }
+    /** set the callback for complete messages on framed connections*/
+    void setMessageCall(
+        std::function<void(TcpConnection::pointer, const char*, size_t)>
+            messageFunc)
+    {
+        messageCall = std::move(messageFunc);
+    }
     /** set a logging function */
     void setLoggingFunction(
         std::function<void(int loglevel, const std::string& logMessage)>
@@ -104,8 +191,16 @@ class TcpServer : public std::enable_shared_from_this<TcpServer> {
     void handle_accept(
         TcpAcceptor::pointer acc,
         TcpConnection::pointer new_connection);
-    /** get a socket by it identification code*/
+    /** get a socket by it identification code
+    @return the connection or nullptr if there is no connection with the
+    identifier*/
     TcpConnection::pointer findSocket(int connectorID) const;
+    /** get the combined traffic statistics of the current connections*/
+    TcpConnection::Statistics getStatistics() const;
+    /** get the traffic statistics of each current connection along with its
+     * identification code, ordered by the identification code*/
+    std::vector<std::pair<int, TcpConnection::Statistics>>
+        getConnectionStatistics() const;
 
   private:
     TcpServer(
@@ -147,22 +242,44 @@ class TcpServer : public std::enable_shared_from_this<TcpServer> {
         int nominalBufferSize);
 
     void initialConnect();
+    /** remove all the connections from the table
+    @return the removed connections*/
+    std::vector<TcpConnection::pointer> takeConnections();
+    /** set up an accepted connection once its handshake is done and add it
+     * to the connections*/
+    void completeAccept(const TcpConnection::pointer& new_connection);
+    /** create a connection for an acceptor to accept into*/
+    TcpConnection::pointer newConnection(const TcpAcceptor& acc);
     void logger(int level, const std::string& message);
 
     asio::io_context& ioctx;
     SocketFactory socket_factory;
-    mutable std::mutex accepting;
     std::vector<TcpAcceptor::pointer> acceptors;
     std::vector<asio::ip::tcp::endpoint> endpoints;
     size_t bufferSize;
+    size_t maxBufferSize{TcpConnection::defaultMaxBufferSize};
+    size_t zeroCopyThreshold{0};
+    size_t readBudget{0};
     std::function<size_t(TcpConnection::pointer, const char*, size_t)> dataCall;
+    std::function<void(TcpConnection::pointer, const char*, size_t)>
+        messageCall;
     std::function<bool(TcpConnection::pointer, const std::error_code& error)>
         errorCall;
     std::function<void(int level, const std::string& logMessage)> logFunction;
     std::atomic<bool> halted{false};
     bool reuse_address = false;
-    // this data structure is protected by the accepting mutex
-    std::vector<TcpConnection::pointer> connections;
+    TcpConnection::ReceiveBufferMode receiveMode{
+        TcpConnection::ReceiveBufferMode::VECTOR};
+    FramingMode framing{FramingMode::NONE};
+    std::shared_ptr<LatencyHistograms> histograms;
+    std::shared_ptr<AsioContextPool> contextPool;
+    PoolMode poolMode{PoolMode::ROUND_ROBIN};
+    int listenBacklog{asio::socket_base::max_listen_connections};
+    int pendingAccepts{defaultPendingAccepts};
+    /// the accepted connections indexed by their identifier, lookups only
+    /// take a shared lock so they do not block each other
+    shared_guarded<std::unordered_map<int, TcpConnection::pointer>>
+        connections;
 };
 
 }  // namespace gmlc::networking
@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "ZeroCopyTracker.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// older C libraries do not define these even if the kernel supports them
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#endif
+
+namespace gmlc::networking {
+
+#ifdef __linux__
+const int ZeroCopyTracker::sendFlag{MSG_ZEROCOPY};
+
+std::error_code ZeroCopyTracker::enable(int descriptor)
+{
+    const int one{1};
+    if (setsockopt(descriptor, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) !=
+        0) {
+        return {errno, std::system_category()};
+    }
+    return {};
+}
+#else
+const int ZeroCopyTracker::sendFlag{0};
+
+std::error_code ZeroCopyTracker::enable(int /*descriptor*/)
+{
+    return std::make_error_code(std::errc::operation_not_supported);
+}
+#endif
+
+std::uint64_t ZeroCopyTracker::beginBuffer(std::function<void()> release)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    TrackedBuffer buffer;
+    buffer.key = nextKey++;
+    buffer.release = std::move(release);
+    buffer.firstId = nextId;
+    buffers.push_back(std::move(buffer));
+    return buffers.back().key;
+}
+
+void ZeroCopyTracker::recordSend(std::uint64_t key)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& buffer : buffers) {
+        if (buffer.key == key) {
+            if (buffer.sendCount == 0) {
+                buffer.firstId = nextId;
+            }
+            ++buffer.sendCount;
+            ++nextId;
+            return;
+        }
+    }
+}
+
+std::function<void()> ZeroCopyTracker::endBuffer(std::uint64_t key)
+{
+    std::vector<std::function<void()>> released;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& buffer : buffers) {
+            if (buffer.key == key) {
+                buffer.ended = true;
+                break;
+            }
+        }
+        collectReleased(released);
+    }
+    if (released.empty()) {
+        return {};
+    }
+    return [released = std::move(released)]() {
+        for (const auto& release : released) {
+            if (release) {
+                release();
+            }
+        }
+    };
+}
+
+bool ZeroCopyTracker::startWait()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (waiting || buffers.empty()) {
+        return false;
+    }
+    waiting = true;
+    return true;
+}
+
+#ifdef __linux__
+std::vector<std::function<void()>>
+    ZeroCopyTracker::readCompletions(int descriptor)
+{
+    std::vector<std::function<void()>> released;
+    std::lock_guard<std::mutex> guard(lock);
+    waiting = false;
+    while (true) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err)) + 64];
+        msghdr message{};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        if (recvmsg(descriptor, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        for (auto* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            const bool ipLevel =
+                (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                (cmsg->cmsg_level == SOL_IPV6 &&
+                 cmsg->cmsg_type == IPV6_RECVERR);
+            if (!ipLevel) {
+                continue;
+            }
+            const auto* err =
+                reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cmsg));
+            if (err->ee_errno != 0 ||
+                err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            // the notification covers the inclusive range [ee_info, ee_data]
+            const std::uint32_t low = err->ee_info;
+            const std::uint32_t high = err->ee_data;
+            if ((err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {
+                copiedCount += high - low + 1;
+            }
+            for (auto& buffer : buffers) {
+                if (buffer.sendCount == 0) {
+                    continue;
+                }
+                const std::uint32_t last =
+                    buffer.firstId + buffer.sendCount - 1;
+                const auto overlapLow = (std::max)(low, buffer.firstId);
+                const auto overlapHigh = (std::min)(high, last);
+                if (overlapLow <= overlapHigh) {
+                    buffer.completed += overlapHigh - overlapLow + 1;
+                }
+            }
+        }
+    }
+    collectReleased(released);
+    return released;
+}
+#else
+std::vector<std::function<void()>>
+    ZeroCopyTracker::readCompletions(int /*descriptor*/)
+{
+    std::vector<std::function<void()>> released;
+    std::lock_guard<std::mutex> guard(lock);
+    waiting = false;
+    collectReleased(released);
+    return released;
+}
+#endif
+
+std::vector<std::function<void()>> ZeroCopyTracker::releaseAll()
+{
+    std::vector<std::function<void()>> released;
+    std::lock_guard<std::mutex> guard(lock);
+    waiting = false;
+    for (auto& buffer : buffers) {
+        released.push_back(std::move(buffer.release));
+    }
+    buffers.clear();
+    return released;
+}
+
+std::size_t ZeroCopyTracker::getCopiedCount() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return copiedCount;
+}
+
+void ZeroCopyTracker::collectReleased(
+    std::vector<std::function<void()>>& released)
+{
+    auto split = std::stable_partition(
+        buffers.begin(), buffers.end(), [](const TrackedBuffer& buffer) {
+            return !buffer.ended || buffer.completed < buffer.sendCount;
+        });
+    for (auto it = split; it != buffers.end(); ++it) {
+        released.push_back(std::move(it->release));
+    }
+    buffers.erase(split, buffers.end());
+}
+
+}  // namespace gmlc::networking
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+/** @file
+bookkeeping for sends using the linux MSG_ZEROCOPY flag
+*/
+namespace gmlc::networking {
+/** track buffers sent with MSG_ZEROCOPY until the kernel releases them
+@details every successful send call with the MSG_ZEROCOPY flag is given a
+sequence number by the kernel, and the socket error queue reports ranges of
+sequence numbers once the kernel no longer references the data.  A buffer may
+take several send calls, its release callback runs once all of them are
+reported.
+*/
+class ZeroCopyTracker {
+  public:
+    /// the flag to pass to send for zero copy transmission (0 if unavailable)
+    static const int sendFlag;
+    /** enable zero copy transmission on a socket
+    @return an error if the platform or kernel does not support it*/
+    static std::error_code enable(int descriptor);
+
+    /** start tracking a buffer
+    @param release callback to execute once the kernel releases the buffer
+    @return a key to identify the buffer*/
+    std::uint64_t beginBuffer(std::function<void()> release);
+    /** record a successful send call with the zero copy flag for a buffer*/
+    void recordSend(std::uint64_t key);
+    /** mark that no further send calls will be made for a buffer
+    @return the release callback if the buffer is no longer referenced by the
+    kernel, otherwise an empty function*/
+    std::function<void()> endBuffer(std::uint64_t key);
+    /** check if a wait on the error queue should be started
+    @return true if there are sends awaiting completion and no wait is in
+    progress, the caller must then start a wait*/
+    bool startWait();
+    /** read the completion notifications from the socket error queue and
+    end the current wait
+    @return the release callbacks for buffers that are no longer in use*/
+    std::vector<std::function<void()>> readCompletions(int descriptor);
+    /** stop tracking all buffers, for use when the socket is closed
+    @return the release callbacks for every tracked buffer*/
+    std::vector<std::function<void()>> releaseAll();
+    /** get the number of send calls the kernel completed by copying the data
+     * instead*/
+    std::size_t getCopiedCount() const;
+
+  private:
+    struct TrackedBuffer {
+        std::uint64_t key{0};
+        std::function<void()> release;
+        std::uint32_t firstId{0};  //!< sequence number of the first send
+        std::uint32_t sendCount{0};  //!< number of sends made for the buffer
+        std::uint32_t completed{0};  //!< number of sends reported complete
+        bool ended{false};  //!< no more sends will be made
+    };
+    /** collect the release callbacks of completed buffers, must hold lock*/
+    void collectReleased(std::vector<std::function<void()>>& released);
+
+    mutable std::mutex lock;
+    std::deque<TrackedBuffer> buffers;
+    std::uint64_t nextKey{0};
+    std::uint32_t nextId{0};
+    std::size_t copiedCount{0};
+    bool waiting{false};
+};
+}  // namespace gmlc::networking
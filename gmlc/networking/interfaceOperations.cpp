@@ -11,12 +11,14 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
 #include "AsioContextManager.h"
+#include "ResolutionCache.h"
 #include <asio/ip/host_name.hpp>
 #include <asio/ip/tcp.hpp>
 #endif
 
 #include <algorithm>
 #include <string>
+#include <system_error>
 #include <vector>
 
 namespace gmlc::networking {
@@ -69,11 +71,15 @@ std::string getLocalExternalAddressV4()
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
     auto srv = AsioContextManager::getContextPointer();
 
-    asio::ip::tcp::resolver resolver(srv->getBaseContext());
+    auto resolver = ResolutionCache::instance();
 
     std::error_code ec;
-    asio::ip::tcp::resolver::results_type results =
-        resolver.resolve(asio::ip::tcp::v4(), asio::ip::host_name(), "", ec);
+    asio::ip::tcp::resolver::results_type results = resolver->resolve(
+        srv->getBaseContext(),
+        asio::ip::tcp::v4(),
+        asio::ip::host_name(),
+        "",
+        ec);
 
     if (!ec) {
         asio::ip::tcp::endpoint endpoint = *results.begin();
@@ -126,11 +132,11 @@ std::string getLocalExternalAddressV4(const std::string& server)
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
     auto srv = gmlc::networking::AsioContextManager::getContextPointer();
 
-    asio::ip::tcp::resolver resolver(srv->getBaseContext());
+    auto resolver = ResolutionCache::instance();
 
     std::error_code ec;
-    asio::ip::tcp::resolver::results_type results_server =
-        resolver.resolve(asio::ip::tcp::v4(), server, "", ec);
+    asio::ip::tcp::resolver::results_type results_server = resolver->resolve(
+        srv->getBaseContext(), asio::ip::tcp::v4(), server, "", ec);
     if (ec) {
         return getLocalExternalAddressV4();
     }
@@ -146,8 +152,12 @@ std::string getLocalExternalAddressV4(const std::string& server)
 
     std::vector<std::string> resolved_addresses;
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
-    asio::ip::tcp::resolver::results_type results =
-        resolver.resolve(asio::ip::tcp::v4(), asio::ip::host_name(), "", ec);
+    asio::ip::tcp::resolver::results_type results = resolver->resolve(
+        srv->getBaseContext(),
+        asio::ip::tcp::v4(),
+        asio::ip::host_name(),
+        "",
+        ec);
     if (ec) {
         return getLocalExternalAddressV4();
     }
@@ -179,9 +189,17 @@ std::string getLocalExternalAddressV6()
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
     auto srv = gmlc::networking::AsioContextManager::getContextPointer();
 
-    asio::ip::tcp::resolver resolver(srv->getBaseContext());
-    asio::ip::tcp::resolver::results_type results =
-        resolver.resolve(asio::ip::tcp::v6(), asio::ip::host_name(), "");
+    auto resolver = ResolutionCache::instance();
+    std::error_code ec;
+    asio::ip::tcp::resolver::results_type results = resolver->resolve(
+        srv->getBaseContext(),
+        asio::ip::tcp::v6(),
+        asio::ip::host_name(),
+        "",
+        ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
     asio::ip::tcp::endpoint endpoint = *results.begin();
 
     auto resolved_address = endpoint.address().to_string();
@@ -232,10 +250,14 @@ std::string getLocalExternalAddressV6(const std::string& server)
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
     auto srv = gmlc::networking::AsioContextManager::getContextPointer();
 
-    asio::ip::tcp::resolver resolver(srv->getBaseContext());
+    auto resolver = ResolutionCache::instance();
 
-    asio::ip::tcp::resolver::results_type it_server =
-        resolver.resolve(asio::ip::tcp::v6(), server, "");
+    std::error_code ec;
+    asio::ip::tcp::resolver::results_type it_server = resolver->resolve(
+        srv->getBaseContext(), asio::ip::tcp::v6(), server, "", ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
     asio::ip::tcp::endpoint servep = *it_server.begin();
 
     auto sstring = (it_server.empty()) ? server : servep.address().to_string();
@@ -246,8 +268,15 @@ std::string getLocalExternalAddressV6(const std::string& server)
     std::vector<std::string> resolved_addresses;
 #ifndef GMLC_NETWORKING_DISABLE_ASIO
 
-    asio::ip::tcp::resolver::results_type results =
-        resolver.resolve(asio::ip::tcp::v6(), asio::ip::host_name(), "");
+    asio::ip::tcp::resolver::results_type results = resolver->resolve(
+        srv->getBaseContext(),
+        asio::ip::tcp::v6(),
+        asio::ip::host_name(),
+        "",
+        ec);
+    if (ec) {
+        throw std::system_error(ec);
+    }
     // asio::ip::tcp::endpoint endpoint = *it;
 
     for (const asio::ip::tcp::endpoint& ept : results) {
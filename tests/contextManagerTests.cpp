@@ -1,7 +1,19 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
 #include "gmlc/networking/AsioContextManager.h"
+#include "gmlc/networking/AsioContextPool.h"
+
+#include <asio/post.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
 #include <stdlib.h>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
 using namespace gmlc::networking;
 
@@ -61,3 +73,102 @@ TEST_CASE("runContextTestFail", "[contextManager]")
         gmlc::networking::AsioContextManager::runContextLoop("nonexistent"),
         "the context name specified was not available");
 }
+
+TEST_CASE("threadCountTest", "[contextManager]")
+{
+    auto context_pointer =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "threaded_context");
+    CHECK(context_pointer->getThreadCount() == 1);
+    gmlc::networking::AsioContextManager::setContextThreadCount(
+        4, "threaded_context");
+    CHECK(context_pointer->getThreadCount() == 4);
+
+    constexpr int taskCount{4};
+    std::atomic<int> arrived{0};
+    std::atomic<int> completed{0};
+    std::mutex idLock;
+    std::set<std::thread::id> ids;
+    {
+        auto loop = context_pointer->startContextLoop();
+        CHECK(context_pointer->isRunning());
+        for (int ii = 0; ii < taskCount; ++ii) {
+            asio::post(context_pointer->getBaseContext(), [&]() {
+                {
+                    std::lock_guard<std::mutex> lock(idLock);
+                    ids.insert(std::this_thread::get_id());
+                }
+                // every task blocks until all have started so they must be
+                // running on separate threads
+                ++arrived;
+                auto limit =
+                    std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (arrived.load() < taskCount &&
+                       std::chrono::steady_clock::now() < limit) {
+                    std::this_thread::yield();
+                }
+                ++completed;
+            });
+        }
+        auto limit = std::chrono::steady_clock::now() + std::chrono::seconds(6);
+        while (completed.load() < taskCount &&
+               std::chrono::steady_clock::now() < limit) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    CHECK(completed.load() == taskCount);
+    CHECK(ids.size() == taskCount);
+    // all the threads are joined once the last handle is released
+    CHECK_FALSE(context_pointer->isRunning());
+
+    context_pointer->setThreadCount(0);
+    CHECK(context_pointer->getThreadCount() >= 1);
+}
+
+TEST_CASE("contextPoolTest", "[contextManager]")
+{
+    auto pool = gmlc::networking::AsioContextPool::create("pool", 2, true);
+    REQUIRE(pool->size() == 2);
+    auto* first = &pool->nextContext();
+    auto* second = &pool->nextContext();
+    CHECK(first != second);
+    CHECK(&pool->nextContext() == first);
+    CHECK(&pool->getContext(std::string("host:1234")) ==
+          &pool->getContext(std::string("host:1234")));
+    CHECK(&pool->getContext(size_t{3}) == second);
+    CHECK(pool->getContextManager(0)->getName() == "pool#0");
+    CHECK(pool->getContextManager(1)->getCpuAffinity() >= 0);
+    CHECK_THROWS_AS(pool->getContextManager(2), std::out_of_range);
+
+    pool->start();
+    CHECK(pool->isRunning());
+    std::atomic<int> completed{0};
+    std::mutex nameLock;
+    std::set<std::string> names;
+    for (size_t ii = 0; ii < pool->size(); ++ii) {
+        asio::post(pool->getContext(ii), [&]() {
+#ifdef __linux__
+            char threadName[16] = {};
+            pthread_getname_np(pthread_self(), threadName, sizeof(threadName));
+            std::lock_guard<std::mutex> lock(nameLock);
+            names.insert(threadName);
+#endif
+            ++completed;
+        });
+    }
+    auto limit = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (completed.load() < 2 && std::chrono::steady_clock::now() < limit) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(completed.load() == 2);
+#ifdef __linux__
+    CHECK(names == std::set<std::string>{"pool0", "pool1"});
+#endif
+    pool->stop();
+    CHECK_FALSE(pool->isRunning());
+    CHECK_FALSE(pool->getContextManager(0)->isRunning());
+    pool.reset();
+    CHECK(
+        gmlc::networking::AsioContextManager::getExistingContextPointer(
+            "pool#0") == nullptr);
+}
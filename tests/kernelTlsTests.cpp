@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#ifdef GMLC_NETWORKING_ENABLE_ENCRYPTION
+#include "gmlc/networking/AsioContextManager.h"
+#include "gmlc/networking/KernelTls.hpp"
+#include "gmlc/networking/SocketFactory.h"
+#include "gmlc/networking/TcpConnection.h"
+#include "gmlc/networking/TcpServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <openssl/evp.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gmlc::networking;
+
+namespace {
+/** an SSL object fed through a memory BIO like an asio stream*/
+struct MemoryConnection {
+    SSL* ssl{nullptr};
+    BIO* network{nullptr};
+
+    explicit MemoryConnection(SSL_CTX* context)
+    {
+        ssl = SSL_new(context);
+        BIO* internal{nullptr};
+        BIO_new_bio_pair(&internal, 0, &network, 0);
+        SSL_set_bio(ssl, internal, internal);
+    }
+    ~MemoryConnection()
+    {
+        SSL_free(ssl);
+        BIO_free(network);
+    }
+    MemoryConnection(const MemoryConnection&) = delete;
+    MemoryConnection& operator=(const MemoryConnection&) = delete;
+
+    /** take everything the connection has written*/
+    std::vector<unsigned char> take()
+    {
+        std::vector<unsigned char> data(BIO_ctrl_pending(network));
+        if (!data.empty()) {
+            BIO_read(network, data.data(), static_cast<int>(data.size()));
+        }
+        return data;
+    }
+    void give(const std::vector<unsigned char>& data)
+    {
+        if (!data.empty()) {
+            BIO_write(network, data.data(), static_cast<int>(data.size()));
+        }
+    }
+};
+
+/** decrypt a single TLS 1.3 record with the parameters given to the kernel*/
+std::string decryptRecord(
+    const KernelTlsParameters& parameters,
+    const std::vector<unsigned char>& record)
+{
+    constexpr size_t headerSize{5};
+    constexpr size_t tagSize{16};
+    if (record.size() < headerSize + tagSize) {
+        return {};
+    }
+    auto nonce = parameters.iv;
+    for (size_t ii = 0; ii < 8; ++ii) {
+        nonce[nonce.size() - 1 - ii] ^=
+            static_cast<unsigned char>(parameters.sequence >> (8U * ii));
+    }
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> context(
+        EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+    const EVP_CIPHER* cipher = (parameters.key.size() == 16) ?
+        EVP_aes_128_gcm() :
+        EVP_aes_256_gcm();
+    std::vector<unsigned char> plain(record.size());
+    std::vector<unsigned char> tag(record.end() - tagSize, record.end());
+    int length{0};
+    int finalLength{0};
+    const auto cipherSize =
+        static_cast<int>(record.size() - headerSize - tagSize);
+    bool success =
+        EVP_DecryptInit_ex(
+            context.get(),
+            cipher,
+            nullptr,
+            parameters.key.data(),
+            nonce.data()) > 0 &&
+        EVP_DecryptUpdate(
+            context.get(), nullptr, &length, record.data(), headerSize) > 0 &&
+        EVP_DecryptUpdate(
+            context.get(),
+            plain.data(),
+            &length,
+            record.data() + headerSize,
+            cipherSize) > 0 &&
+        EVP_CIPHER_CTX_ctrl(
+            context.get(), EVP_CTRL_GCM_SET_TAG, tagSize, tag.data()) > 0 &&
+        EVP_DecryptFinal_ex(
+            context.get(), plain.data() + length, &finalLength) > 0;
+    if (!success) {
+        return {};
+    }
+    return std::string(
+        reinterpret_cast<const char*>(plain.data()), length + finalLength);
+}
+
+SocketFactory kernelTlsFactory()
+{
+    SocketFactory sf(
+        std::string(TEST_BINDIR) + "/test_files/ssl_encryption_config.json");
+    sf.parse_json_config(R"({"kernel_tls": true})");
+    return sf;
+}
+}  // namespace
+
+TEST_CASE("kernelTlsParametersTest", "[kernelTls]")
+{
+    auto sf = kernelTlsFactory();
+    auto context = sf.get_ssl_context();
+    MemoryConnection server(context->native_handle());
+    MemoryConnection client(context->native_handle());
+    SSL_set_accept_state(server.ssl);
+    SSL_set_connect_state(client.ssl);
+
+    KernelTlsParameters parameters;
+    // untracked connections have no parameters
+    CHECK_FALSE(KernelTls::transmitParameters(server.ssl, parameters));
+    KernelTls::track(server.ssl);
+    KernelTls::track(client.ssl);
+
+    for (int ii = 0; ii < 20; ++ii) {
+        SSL_do_handshake(client.ssl);
+        server.give(client.take());
+        SSL_do_handshake(server.ssl);
+        client.give(server.take());
+        if (SSL_is_init_finished(client.ssl) == 1 &&
+            SSL_is_init_finished(server.ssl) == 1) {
+            break;
+        }
+    }
+    REQUIRE(SSL_is_init_finished(client.ssl) == 1);
+    REQUIRE(SSL_is_init_finished(server.ssl) == 1);
+    REQUIRE(SSL_version(server.ssl) == TLS1_3_VERSION);
+    // anything sent so far, such as session tickets, is already delivered
+    client.take();
+    server.take();
+
+    // the next records must decrypt with the key, iv, and sequence number the
+    // kernel would be given
+    REQUIRE(KernelTls::transmitParameters(server.ssl, parameters));
+    CHECK(SSL_write(server.ssl, "kernel", 6) == 6);
+    CHECK(decryptRecord(parameters, server.take()) == "kernel\x17");
+
+    REQUIRE(KernelTls::transmitParameters(client.ssl, parameters));
+    CHECK(parameters.sequence == 0);
+    CHECK(SSL_write(client.ssl, "client", 6) == 6);
+    CHECK(decryptRecord(parameters, client.take()) == "client\x17");
+
+    // a descriptor that is not a tcp socket cannot use kernel TLS
+    CHECK(KernelTls::enableTransmit(server.ssl, -1));
+}
+
+TEST_CASE("kernelTlsConnectionTest", "[kernelTls]")
+{
+    // the connection works whether or not the kernel supports TLS
+    auto sf = kernelTlsFactory();
+    auto ioctx = AsioContextManager::getContextPointer("kernelTls");
+    auto server =
+        TcpServer::create(sf, ioctx->getBaseContext(), "*", 10101, true);
+    REQUIRE(server->isReady());
+    auto ctxloop = ioctx->startContextLoop();
+    std::atomic<size_t> serverReceived{0};
+    server->setDataCall([&serverReceived](
+                            const TcpConnection::pointer& connection,
+                            const char* data,
+                            size_t datasize) {
+        serverReceived += datasize;
+        connection->send(data, datasize);
+        return datasize;
+    });
+    REQUIRE(server->start());
+
+    std::atomic<size_t> clientReceived{0};
+    auto connection = TcpConnection::create(
+        sf, ioctx->getBaseContext(), "127.0.0.1", "10101");
+    connection->setDataCall(
+        [&clientReceived](
+            const TcpConnection::pointer&, const char*, size_t datasize) {
+            clientReceived += datasize;
+            return datasize;
+        });
+    REQUIRE(connection->waitUntilConnected(std::chrono::seconds(5)));
+    connection->startReceive();
+    const std::string message(10000, 'k');
+    connection->send(message);
+    int itCount{0};
+    while (clientReceived.load() < message.size() && itCount++ < 200) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(serverReceived.load() == message.size());
+    CHECK(clientReceived.load() == message.size());
+    INFO("kernel TLS active " << connection->socket()->kernel_tls_active());
+    connection->close();
+    server->close();
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include "gmlc/networking/LatencyHistogram.hpp"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace gmlc::networking;
+
+TEST_CASE("bucketBoundaries", "[histogram]")
+{
+    for (std::uint64_t value = 0; value < 16; ++value) {
+        CHECK(LatencyHistogram::bucketIndex(value) == value);
+        CHECK(LatencyHistogram::bucketUpperBound(value) == value);
+    }
+    CHECK(LatencyHistogram::bucketIndex(16) == 16);
+    CHECK(LatencyHistogram::bucketIndex(31) == 31);
+    CHECK(LatencyHistogram::bucketIndex(32) == 32);
+    CHECK(LatencyHistogram::bucketIndex(33) == 32);
+    CHECK(LatencyHistogram::bucketUpperBound(32) == 33);
+    CHECK(
+        LatencyHistogram::bucketIndex(UINT64_MAX) ==
+        LatencyHistogram::bucketCount - 1);
+    CHECK(
+        LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketCount - 1) ==
+        UINT64_MAX);
+    // every value is at or below the upper bound of its bucket and above the
+    // upper bound of the previous one
+    const std::vector<std::uint64_t> values{17, 100, 1000, 123456, 1ULL << 40};
+    for (auto value : values) {
+        auto index = LatencyHistogram::bucketIndex(value);
+        CHECK(LatencyHistogram::bucketUpperBound(index) >= value);
+        CHECK(LatencyHistogram::bucketUpperBound(index - 1) < value);
+    }
+}
+
+TEST_CASE("percentiles", "[histogram]")
+{
+    LatencyHistogram hist;
+    CHECK(hist.count() == 0);
+    CHECK(hist.percentile(0.5) == 0);
+    for (std::uint64_t value = 1; value <= 1000; ++value) {
+        hist.record(value * 1000);
+    }
+    CHECK(hist.count() == 1000);
+    CHECK(hist.max() == 1000000);
+    CHECK(hist.mean() == Approx(500500.0));
+    auto median = hist.percentile(0.5);
+    CHECK(median >= 500000);
+    CHECK(median <= 500000 * 107 / 100);
+    auto p99 = hist.percentile(0.99);
+    CHECK(p99 >= 990000);
+    CHECK(p99 <= 1000000);
+    CHECK(hist.percentile(1.0) == 1000000);
+
+    hist.reset();
+    CHECK(hist.count() == 0);
+    CHECK(hist.max() == 0);
+}
+
+TEST_CASE("merge", "[histogram]")
+{
+    LatencyHistograms total;
+    std::vector<std::thread> threads;
+    std::vector<LatencyHistograms> parts(4);
+    for (auto& part : parts) {
+        threads.emplace_back([&part]() {
+            for (std::uint64_t value = 0; value < 10000; ++value) {
+                part.callback.record(value);
+            }
+            part.send.record(std::chrono::microseconds(5));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& part : parts) {
+        total.merge(part);
+    }
+    CHECK(total.callback.count() == 40000);
+    CHECK(total.callback.max() == 9999);
+    CHECK(total.send.count() == 4);
+    CHECK(total.send.max() == 5000);
+    CHECK(total.dispatch.count() == 0);
+}
+
+TEST_CASE("scopedLatency", "[histogram]")
+{
+    LatencyHistogram hist;
+    {
+        ScopedLatency timer(&hist);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    {
+        ScopedLatency timer(nullptr);
+    }
+    if (latencyHistogramsEnabled) {
+        CHECK(hist.count() == 1);
+        CHECK(hist.max() >= 2000000);
+    } else {
+        CHECK(hist.count() == 0);
+    }
+}
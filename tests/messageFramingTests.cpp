@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include "gmlc/networking/MessageFraming.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace gmlc::networking;
+
+static std::string frame(FramingMode mode, const std::string& message)
+{
+    std::array<char, maxFrameHeaderSize> header{};
+    auto headerSize = encodeFrameHeader(mode, message.size(), header.data());
+    return std::string(header.data(), headerSize) + message;
+}
+
+TEST_CASE("headerRoundTrip", "[framing]")
+{
+    const std::vector<std::uint64_t> lengths{
+        0, 1, 127, 128, 300, 65535, 16777216, 0xFFFFFFFFULL};
+    for (auto mode :
+         {FramingMode::VARINT, FramingMode::FIXED32, FramingMode::FIXED64}) {
+        for (auto length : lengths) {
+            std::array<char, maxFrameHeaderSize> header{};
+            auto headerSize = encodeFrameHeader(mode, length, header.data());
+            std::uint64_t decoded{0};
+            CHECK(
+                decodeFrameHeader(mode, header.data(), headerSize, decoded) ==
+                headerSize);
+            CHECK(decoded == length);
+            // a truncated header needs more data
+            CHECK(
+                decodeFrameHeader(
+                    mode, header.data(), headerSize - 1, decoded) == 0);
+        }
+    }
+}
+
+TEST_CASE("headerSizes", "[framing]")
+{
+    std::array<char, maxFrameHeaderSize> header{};
+    CHECK(encodeFrameHeader(FramingMode::NONE, 100, header.data()) == 0);
+    CHECK(encodeFrameHeader(FramingMode::FIXED32, 100, header.data()) == 4);
+    CHECK(encodeFrameHeader(FramingMode::FIXED64, 100, header.data()) == 8);
+    CHECK(
+        encodeFrameHeader(FramingMode::FIXED32, 0xFFFFFFFFULL, header.data()) ==
+        4);
+    CHECK(
+        encodeFrameHeader(
+            FramingMode::FIXED32, 0x100000000ULL, header.data()) == 0);
+    CHECK(
+        encodeFrameHeader(
+            FramingMode::FIXED64, 0x100000000ULL, header.data()) == 8);
+    CHECK(encodeFrameHeader(FramingMode::VARINT, 100, header.data()) == 1);
+    CHECK(encodeFrameHeader(FramingMode::VARINT, 300, header.data()) == 2);
+    CHECK(
+        encodeFrameHeader(FramingMode::VARINT, UINT64_MAX, header.data()) ==
+        maxFrameHeaderSize);
+}
+
+TEST_CASE("invalidVarint", "[framing]")
+{
+    std::string header(maxFrameHeaderSize + 1, static_cast<char>(0x80));
+    std::uint64_t decoded{0};
+    CHECK(
+        decodeFrameHeader(
+            FramingMode::VARINT, header.data(), header.size(), decoded) ==
+        invalidFrameHeader);
+
+    std::error_code error;
+    auto used = parseFrames(
+        FramingMode::VARINT,
+        header.data(),
+        header.size(),
+        1000,
+        [](const char*, size_t) { CHECK(false); },
+        error);
+    CHECK(used == 0);
+    CHECK(error == std::errc::bad_message);
+}
+
+TEST_CASE("parsePartialFrames", "[framing]")
+{
+    const auto mode = FramingMode::FIXED32;
+    std::string stream = frame(mode, "first") + frame(mode, "") +
+        frame(mode, "second message");
+    const auto completeSize = stream.size();
+    stream += frame(mode, "incomplete message").substr(0, 10);
+
+    std::vector<std::string> messages;
+    std::error_code error;
+    auto used = parseFrames(
+        mode,
+        stream.data(),
+        stream.size(),
+        1000,
+        [&messages](const char* message, size_t length) {
+            messages.emplace_back(message, length);
+        },
+        error);
+    CHECK(!error);
+    CHECK(used == completeSize);
+    REQUIRE(messages.size() == 3);
+    CHECK(messages[0] == "first");
+    CHECK(messages[1].empty());
+    CHECK(messages[2] == "second message");
+}
+
+TEST_CASE("parseOversizeFrame", "[framing]")
+{
+    const auto mode = FramingMode::VARINT;
+    std::string stream = frame(mode, "ok") + frame(mode, std::string(200, 'a'));
+
+    int count{0};
+    std::error_code error;
+    auto used = parseFrames(
+        mode,
+        stream.data(),
+        stream.size(),
+        100,
+        [&count](const char*, size_t) { ++count; },
+        error);
+    CHECK(count == 1);
+    CHECK(used == 3);
+    CHECK(error == std::errc::message_size);
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include "gmlc/networking/MirroredBuffer.hpp"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+using namespace gmlc::networking;
+
+TEST_CASE("capacityRounding", "[mirroredBuffer]")
+{
+    if (!MirroredBuffer::isSupported()) {
+        return;
+    }
+    MirroredBuffer buffer(10192);
+    CHECK(buffer.capacity() >= 10192);
+    CHECK(buffer.capacity() % MirroredBuffer::granularity() == 0);
+    CHECK(buffer.empty());
+    CHECK(buffer.freeSpace() == buffer.capacity());
+}
+
+TEST_CASE("mirroredView", "[mirroredBuffer]")
+{
+    if (!MirroredBuffer::isSupported()) {
+        return;
+    }
+    MirroredBuffer buffer(1);
+    auto cap = buffer.capacity();
+    // writes into the first mapping are visible in the second
+    buffer.writeLocation()[0] = 'a';
+    CHECK(buffer.writeLocation()[cap] == 'a');
+}
+
+TEST_CASE("wrapAround", "[mirroredBuffer]")
+{
+    if (!MirroredBuffer::isSupported()) {
+        return;
+    }
+    MirroredBuffer buffer(1);
+    auto cap = buffer.capacity();
+    // move the read position close to the end of the ring
+    buffer.commit(cap - 3);
+    buffer.consume(cap - 3);
+    CHECK(buffer.empty());
+
+    std::string message = "this message crosses the end of the ring";
+    REQUIRE(buffer.freeSpace() >= message.size());
+    std::memcpy(buffer.writeLocation(), message.data(), message.size());
+    buffer.commit(message.size());
+    CHECK(buffer.size() == message.size());
+    CHECK(std::string(buffer.data(), buffer.size()) == message);
+
+    buffer.consume(5);
+    CHECK(std::string(buffer.data(), buffer.size()) == message.substr(5));
+    buffer.consume(buffer.size());
+    CHECK(buffer.empty());
+}
+
+TEST_CASE("moveBuffer", "[mirroredBuffer]")
+{
+    if (!MirroredBuffer::isSupported()) {
+        return;
+    }
+    MirroredBuffer buffer(1);
+    std::memcpy(buffer.writeLocation(), "test", 4);
+    buffer.commit(4);
+    MirroredBuffer moved(std::move(buffer));
+    CHECK(buffer.capacity() == 0);
+    CHECK(std::string(moved.data(), moved.size()) == "test");
+}
@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include "gmlc/networking/AsioContextManager.h"
+#include "gmlc/networking/TcpOperations.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+using namespace gmlc::networking;
+
+// count every allocation made in any thread while counting is enabled
+static std::atomic<bool> countAllocations{false};
+static std::atomic<std::size_t> allocationCount{0};
+
+static void* countedAllocate(std::size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* pointer = std::malloc((size == 0) ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+static void* countedAllocate(std::size_t size, std::align_val_t align)
+{
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto alignment = static_cast<std::size_t>(align);
+    size = ((size + alignment - 1) / alignment) * alignment;
+#ifdef _WIN32
+    void* pointer = _aligned_malloc((size == 0) ? alignment : size, alignment);
+#else
+    void* pointer =
+        std::aligned_alloc(alignment, (size == 0) ? alignment : size);
+#endif
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+static void countedFree(void* pointer, std::align_val_t /*align*/) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return countedAllocate(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return countedAllocate(size, align);
+}
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::size_t /*size*/) noexcept
+{
+    std::free(pointer);
+}
+void operator delete[](void* pointer, std::size_t /*size*/) noexcept
+{
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::align_val_t align) noexcept
+{
+    countedFree(pointer, align);
+}
+void operator delete[](void* pointer, std::align_val_t align) noexcept
+{
+    countedFree(pointer, align);
+}
+void operator delete(
+    void* pointer,
+    std::size_t /*size*/,
+    std::align_val_t align) noexcept
+{
+    countedFree(pointer, align);
+}
+void operator delete[](
+    void* pointer,
+    std::size_t /*size*/,
+    std::align_val_t align) noexcept
+{
+    countedFree(pointer, align);
+}
+
+TEST_CASE("echoWithoutAllocation", "[receiveLoop]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19890, true, 1024);
+    REQUIRE(spt->isReady());
+    // echo everything straight back
+    spt->setDataCall([](const gmlc::networking::TcpConnection::pointer& conn,
+                        const char* data,
+                        size_t datasize) {
+        conn->send(data, datasize);
+        return datasize;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19890",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    constexpr size_t messageSize = 64;
+    std::atomic<size_t> received{0};
+    cpt->setDataCall([&received](
+                         const gmlc::networking::TcpConnection::pointer&,
+                         const char* /*data*/,
+                         size_t datasize) {
+        received.fetch_add(datasize);
+        return datasize;
+    });
+    cpt->startReceive();
+
+    const std::string message(messageSize, 'e');
+    auto roundTrips = [&](int count) {
+        for (int ii = 0; ii < count; ++ii) {
+            auto target = received.load() + messageSize;
+            cpt->send(message.data(), message.size());
+            int spin{0};
+            while (received.load() < target && spin++ < 1000000) {
+                std::this_thread::yield();
+            }
+            if (received.load() < target) {
+                return false;
+            }
+        }
+        return true;
+    };
+    // warm up so any lazily created structures exist before counting
+    REQUIRE(roundTrips(100));
+
+    countAllocations = true;
+    const bool completed = roundTrips(5000);
+    countAllocations = false;
+    CHECK(completed);
+    CHECK(allocationCount.load() == 0);
+
+    spt->close();
+    cpt->close();
+}
@@ -0,0 +1,189 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "gmlc/networking/AsioContextManager.h"
+#include "gmlc/networking/ResolutionCache.h"
+#include "gmlc/networking/TcpConnection.h"
+#include "gmlc/networking/TcpServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gmlc::networking;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+/** restores the default cache settings when a test ends*/
+struct CacheReset {
+    std::shared_ptr<ResolutionCache> cache{ResolutionCache::instance()};
+    CacheReset() { cache->clear(); }
+    ~CacheReset()
+    {
+        cache->setTimeToLive(ResolutionCache::defaultTimeToLive);
+        cache->setNegativeTimeToLive(
+            ResolutionCache::defaultNegativeTimeToLive);
+        cache->clear();
+    }
+};
+}  // namespace
+
+TEST_CASE("cachedResolveTest", "[resolutionCache]")
+{
+    CacheReset reset;
+    asio::io_context ioctx;
+    const auto before = reset.cache->resolutionCount();
+    std::error_code ec;
+    auto first = reset.cache->resolve(
+        ioctx, asio::ip::tcp::v4(), "127.0.0.1", "19888", ec);
+    REQUIRE_FALSE(ec);
+    REQUIRE_FALSE(first.empty());
+    CHECK(first.begin()->endpoint().port() == 19888);
+    auto second = reset.cache->resolve(
+        ioctx, asio::ip::tcp::v4(), "127.0.0.1", "19888", ec);
+    REQUIRE_FALSE(ec);
+    CHECK(second.begin()->endpoint() == first.begin()->endpoint());
+    CHECK(reset.cache->resolutionCount() == before + 1);
+    CHECK(reset.cache->size() == 1);
+
+    // a different service is a different name
+    reset.cache->resolve(ioctx, asio::ip::tcp::v4(), "127.0.0.1", "19887", ec);
+    CHECK(reset.cache->resolutionCount() == before + 2);
+
+    // without a time to live every request resolves
+    reset.cache->setTimeToLive(0ms);
+    reset.cache->clear();
+    reset.cache->resolve(ioctx, asio::ip::tcp::v4(), "127.0.0.1", "19888", ec);
+    reset.cache->resolve(ioctx, asio::ip::tcp::v4(), "127.0.0.1", "19888", ec);
+    CHECK(reset.cache->resolutionCount() == before + 4);
+}
+
+TEST_CASE("negativeCacheTest", "[resolutionCache]")
+{
+    CacheReset reset;
+    asio::io_context ioctx;
+    const auto before = reset.cache->resolutionCount();
+    std::error_code ec;
+    auto results = reset.cache->resolve(
+        ioctx, asio::ip::tcp::v4(), "127.0.0.1", "no-such-service-name", ec);
+    CHECK(ec);
+    CHECK(results.empty());
+    std::error_code cachedError;
+    reset.cache->resolve(
+        ioctx,
+        asio::ip::tcp::v4(),
+        "127.0.0.1",
+        "no-such-service-name",
+        cachedError);
+    CHECK(cachedError == ec);
+    CHECK(reset.cache->resolutionCount() == before + 1);
+
+    // failures are retried once the negative time to live has passed
+    reset.cache->setNegativeTimeToLive(0ms);
+    reset.cache->clear();
+    reset.cache->resolve(
+        ioctx, asio::ip::tcp::v4(), "127.0.0.1", "no-such-service-name", ec);
+    reset.cache->resolve(
+        ioctx, asio::ip::tcp::v4(), "127.0.0.1", "no-such-service-name", ec);
+    CHECK(ec);
+    CHECK(reset.cache->resolutionCount() == before + 3);
+}
+
+TEST_CASE("sharedAsyncResolveTest", "[resolutionCache]")
+{
+    CacheReset reset;
+    asio::io_context ioctx;
+    const auto before = reset.cache->resolutionCount();
+    constexpr int requests{50};
+    std::atomic<int> completed{0};
+    std::atomic<int> failures{0};
+    for (int ii = 0; ii < requests; ++ii) {
+        reset.cache->asyncResolve(
+            ioctx,
+            asio::ip::tcp::v4(),
+            "localhost",
+            "19888",
+            [&completed, &failures](
+                const std::error_code& ec,
+                const ResolutionCache::results_type& results) {
+                if (ec || results.empty()) {
+                    ++failures;
+                }
+                ++completed;
+            });
+    }
+    // nothing completes until the context runs the single resolution
+    CHECK(completed.load() == 0);
+    ioctx.run();
+    CHECK(completed.load() == requests);
+    CHECK(failures.load() == 0);
+    CHECK(reset.cache->resolutionCount() == before + 1);
+
+    // later requests are answered from the cache immediately
+    bool answered{false};
+    reset.cache->asyncResolve(
+        ioctx,
+        asio::ip::tcp::v4(),
+        "localhost",
+        "19888",
+        [&answered](
+            const std::error_code&, const ResolutionCache::results_type&) {
+            answered = true;
+        });
+    CHECK(answered);
+    CHECK(reset.cache->resolutionCount() == before + 1);
+}
+
+TEST_CASE("connectionsShareResolutionTest", "[resolutionCache]")
+{
+    CacheReset reset;
+    auto ioctx = AsioContextManager::getContextPointer("resolutionCache");
+    auto server =
+        TcpServer::create(ioctx->getBaseContext(), "localhost", "19888", true);
+    REQUIRE(server->isReady());
+    auto ctxloop = ioctx->startContextLoop();
+    server->setDataCall(
+        [](const TcpConnection::pointer&, const char*, size_t datasize) {
+            return datasize;
+        });
+    REQUIRE(server->start());
+
+    // the clients share a single resolution of the server name
+    const auto before = reset.cache->resolutionCount();
+    constexpr int clientCount{20};
+    std::vector<TcpConnection::pointer> clients;
+    for (int ii = 0; ii < clientCount; ++ii) {
+        clients.push_back(TcpConnection::create(
+            ioctx->getBaseContext(), "localhost", "19888"));
+    }
+    for (auto& client : clients) {
+        CHECK(client->waitUntilConnected(5000ms));
+    }
+    CHECK(reset.cache->resolutionCount() == before + 1);
+    for (auto& client : clients) {
+        client->close();
+    }
+    server->close();
+}
+
+TEST_CASE("closeDuringResolveTest", "[resolutionCache]")
+{
+    CacheReset reset;
+    asio::io_context ioctx;
+    auto connection = TcpConnection::create(
+        SocketFactory(), ioctx, "localhost", "19887", nullptr);
+    // the resolution is waiting for the context to run
+    connection->closeNoWait();
+    ioctx.run();
+    CHECK_FALSE(connection->isConnected());
+    // the aborted connect must not reopen the closed socket
+    CHECK_FALSE(connection->socket()->is_open());
+}
@@ -12,9 +12,11 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 #include "gmlc/networking/SocketFactory.h"
 #include "gmlc/networking/TcpConnection.h"
 #include "gmlc/networking/TcpServer.h"
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifndef INFO
 #define INFO(arg)
@@ -133,8 +135,7 @@ TEST_CASE("simple_encrypted_comm_test", "[simpleConnections]")
     INFO("Server started");
 
     INFO("Creating connection...");
-    // Separate client ioctx to prevent race between blocking SSL handshake
-    // functions
+    // Separate client ioctx so the client and server run on different threads
     auto ioctx_client =
         gmlc::networking::AsioContextManager::getContextPointer("client");
     auto connection = gmlc::networking::TcpConnection::create(
@@ -161,4 +162,156 @@ TEST_CASE("simple_encrypted_comm_test", "[simpleConnections]")
     INFO("Data size: " << data_recv_size);
     CHECK(data_recv_size == 4);
 }
+
+/** test case for encrypted connections whose client and server share a single
+ * context thread, which requires the handshakes to be asynchronous*/
+TEST_CASE("shared_context_encrypted_comm_test", "[simpleConnections]")
+{
+    gmlc::networking::SocketFactory sf(
+        std::string(TEST_BINDIR) + "/test_files/ssl_encryption_config.json");
+
+    auto ioctx =
+        gmlc::networking::AsioContextManager::getContextPointer("shared");
+    auto server = gmlc::networking::TcpServer::create(
+        sf, ioctx->getBaseContext(), "*", 10101, true);
+    REQUIRE(server->isReady());
+    auto ctxloop = ioctx->startContextLoop();
+
+    std::atomic<size_t> data_recv_size{0};
+    server->setDataCall(
+        [&](const gmlc::networking::TcpConnection::pointer& /*connection*/,
+            const char* /*data*/,
+            size_t datasize) {
+            data_recv_size += datasize;
+            return datasize;
+        });
+    CHECK(server->start());
+
+    constexpr size_t connectionCount{4};
+    std::vector<gmlc::networking::TcpConnection::pointer> connections;
+    for (size_t ii = 0; ii < connectionCount; ++ii) {
+        connections.push_back(gmlc::networking::TcpConnection::create(
+            sf, ioctx->getBaseContext(), "127.0.0.1", "10101"));
+    }
+    for (auto& connection : connections) {
+        REQUIRE(connection->waitUntilConnected(std::chrono::seconds(5)));
+        connection->send("test");
+    }
+    int itCount{0};
+    while (data_recv_size.load() < connectionCount * 4 && itCount++ < 200) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(data_recv_size.load() == connectionCount * 4);
+    for (auto& connection : connections) {
+        connection->close();
+    }
+    server->close();
+}
+
+/** test case for the ssl context shared by the sockets of a factory*/
+TEST_CASE("ssl_context_cache_test", "[simpleConnections]")
+{
+    gmlc::networking::SocketFactory sf(
+        std::string(TEST_BINDIR) + "/test_files/ssl_encryption_config.json");
+    auto context = sf.get_ssl_context();
+    REQUIRE(context);
+    CHECK(sf.get_ssl_context() == context);
+    // copies of the factory share the context
+    auto copy = sf;
+    CHECK(copy.get_ssl_context() == context);
+
+    auto ioctx =
+        gmlc::networking::AsioContextManager::getContextPointer("shared");
+    auto server = gmlc::networking::TcpServer::create(
+        sf, ioctx->getBaseContext(), "*", 10101, true);
+    REQUIRE(server->isReady());
+    auto ctxloop = ioctx->startContextLoop();
+    std::atomic<size_t> data_recv_size{0};
+    server->setDataCall(
+        [&](const gmlc::networking::TcpConnection::pointer& /*connection*/,
+            const char* /*data*/,
+            size_t datasize) {
+            data_recv_size += datasize;
+            return datasize;
+        });
+    CHECK(server->start());
+    auto first = gmlc::networking::TcpConnection::create(
+        sf, ioctx->getBaseContext(), "127.0.0.1", "10101");
+    REQUIRE(first->waitUntilConnected(std::chrono::seconds(5)));
+
+    sf.reload_ssl_context();
+    auto reloaded = sf.get_ssl_context();
+    CHECK(reloaded != context);
+    CHECK(copy.get_ssl_context() == reloaded);
+    // connections made before and after the reload both work
+    auto second = gmlc::networking::TcpConnection::create(
+        sf, ioctx->getBaseContext(), "127.0.0.1", "10101");
+    REQUIRE(second->waitUntilConnected(std::chrono::seconds(5)));
+    first->send("test");
+    second->send("test");
+    int itCount{0};
+    while (data_recv_size.load() < 8 && itCount++ < 200) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(data_recv_size.load() == 8);
+    first->close();
+    second->close();
+    server->close();
+
+    // changing the settings detaches the factory from its copies
+    copy.parse_json_config(R"({"encrypted": true})");
+    CHECK(copy.get_ssl_context() != reloaded);
+    CHECK(sf.get_ssl_context() == reloaded);
+}
+
+/** test case for resuming a TLS session when reconnecting to a server*/
+TEST_CASE("tls_session_resumption_test", "[simpleConnections]")
+{
+    gmlc::networking::SocketFactory sf(
+        std::string(TEST_BINDIR) + "/test_files/ssl_encryption_config.json");
+    auto sessions = sf.get_session_store();
+    REQUIRE(sessions);
+
+    auto ioctx =
+        gmlc::networking::AsioContextManager::getContextPointer("shared");
+    auto server = gmlc::networking::TcpServer::create(
+        sf, ioctx->getBaseContext(), "*", 10101, true);
+    REQUIRE(server->isReady());
+    auto ctxloop = ioctx->startContextLoop();
+    server->setDataCall(
+        [](const gmlc::networking::TcpConnection::pointer& /*connection*/,
+           const char* /*data*/,
+           size_t datasize) { return datasize; });
+    CHECK(server->start());
+
+    auto connect = [&sf, &ioctx]() {
+        auto connection = gmlc::networking::TcpConnection::create(
+            sf, ioctx->getBaseContext(), "127.0.0.1", "10101");
+        connection->setDataCall(
+            [](const gmlc::networking::TcpConnection::pointer& /*conn*/,
+               const char* /*data*/,
+               size_t datasize) { return datasize; });
+        REQUIRE(connection->waitUntilConnected(std::chrono::seconds(5)));
+        // TLS 1.3 sessions arrive after the handshake so the client reads
+        connection->startReceive();
+        return connection;
+    };
+    auto first = connect();
+    CHECK_FALSE(first->socket()->session_resumed());
+    int itCount{0};
+    while (sessions->size() == 0 && itCount++ < 200) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(sessions->size() == 1);
+    first->close();
+
+    auto second = connect();
+    CHECK(second->socket()->session_resumed());
+    second->close();
+    server->close();
+
+    auto disabled = sf;
+    disabled.parse_json_config(R"({"session_resumption": false})");
+    CHECK_FALSE(disabled.get_session_store());
+}
 #endif
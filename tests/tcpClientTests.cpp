@@ -41,6 +41,28 @@ TEST_CASE("invalidString", "[TcpClient]")
     CHECK_THROWS(TcpConnection::create(io_context, "testString", "0"));
 }
 
+TEST_CASE("invalidStringCallback", "[TcpClient]")
+{
+    // the host is resolved asynchronously so the failure is reported through
+    // the connect callback
+    asio::io_context io_context;
+    bool failed{false};
+    TcpConnection::pointer connection;
+    CHECK_NOTHROW(
+        connection = TcpConnection::create(
+            SocketFactory(),
+            io_context,
+            "testString",
+            "0",
+            [&failed](
+                const TcpConnection::pointer&, const std::error_code& error) {
+                failed = static_cast<bool>(error);
+            }));
+    io_context.run();
+    CHECK(failed);
+    CHECK_FALSE(connection->isConnected());
+}
+
 TEST_CASE("startReceive", "[TcpClient]")
 {
     asio::io_context io_context;
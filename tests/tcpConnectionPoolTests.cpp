@@ -0,0 +1,306 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "gmlc/networking/AsioContextManager.h"
+#include "gmlc/networking/TcpConnectionPool.h"
+#include "gmlc/networking/TcpServer.h"
+
+#include <asio/post.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace gmlc::networking;
+using namespace std::chrono_literals;  // NOLINT
+
+namespace {
+bool waitFor(const std::function<bool()>& condition)
+{
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    return true;
+}
+
+std::shared_ptr<TcpServer> startEchoServer(
+    const std::shared_ptr<gmlc::networking::AsioContextManager>& ioctx)
+{
+    auto server =
+        TcpServer::create(ioctx->getBaseContext(), "localhost", "19888", true);
+    REQUIRE(server->isReady());
+    server->setDataCall(
+        [](const TcpConnection::pointer& connection,
+           const char* data,
+           size_t datasize) {
+            connection->send(data, datasize);
+            return datasize;
+        });
+    REQUIRE(server->start());
+    return server;
+}
+
+/** send a request on a checked out connection and wait for the reply
+@param checkinOnReply return the connection to the pool from inside the data
+callback*/
+std::string request(
+    const std::shared_ptr<TcpConnectionPool>& pool,
+    const TcpConnection::pointer& connection,
+    const std::string& message,
+    bool checkinOnReply)
+{
+    auto reply = std::make_shared<std::promise<std::string>>();
+    auto result = reply->get_future();
+    connection->setDataCall(
+        [pool, reply, size = message.size(), checkinOnReply](
+            const TcpConnection::pointer& conn,
+            const char* data,
+            size_t datasize) {
+            if (datasize < size) {
+                return size_t{0};
+            }
+            reply->set_value(std::string(data, size));
+            if (checkinOnReply) {
+                pool->checkin(conn);
+            }
+            return size;
+        });
+    connection->startReceive();
+    connection->send(message);
+    if (result.wait_for(5s) != std::future_status::ready) {
+        return std::string();
+    }
+    return result.get();
+}
+}  // namespace
+
+TEST_CASE("reuseConnectionTest", "[connectionPool]")
+{
+    auto ioctx = gmlc::networking::AsioContextManager::getContextPointer(
+        "connectionPool");
+    auto ctxloop = ioctx->startContextLoop();
+    auto server = startEchoServer(ioctx);
+    auto pool = TcpConnectionPool::create(ioctx->getBaseContext());
+
+    auto first = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(first);
+    CHECK(request(pool, first, "request1", false) == "request1");
+    CHECK(pool->checkin(first));
+    REQUIRE(waitFor([&pool]() { return pool->idleCount() == 1; }));
+    // a connection can only be checked in once
+    CHECK_FALSE(pool->checkin(first));
+
+    auto second = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(second);
+    CHECK(second == first);
+    CHECK(pool->idleCount() == 0);
+    // the callbacks can be set again on a reused connection
+    CHECK(request(pool, second, "request2", true) == "request2");
+    REQUIRE(waitFor([&pool]() { return pool->idleCount() == 1; }));
+
+    auto stats = pool->getStatistics();
+    CHECK(stats.created == 1);
+    CHECK(stats.reused == 1);
+    CHECK(stats.returned == 2);
+    CHECK(stats.discarded == 0);
+
+    // connections from elsewhere are not taken
+    auto other = TcpConnection::create(
+        ioctx->getBaseContext(), "localhost", "19888");
+    REQUIRE(other->waitUntilConnected(5000ms));
+    CHECK_FALSE(pool->checkin(other));
+    CHECK(other->isConnected());
+    other->close();
+
+    pool->closeAll();
+    CHECK(pool->idleCount() == 0);
+    server->close();
+}
+
+TEST_CASE("closeReusedConnectionTest", "[connectionPool]")
+{
+    auto ioctx = gmlc::networking::AsioContextManager::getContextPointer(
+        "connectionPool");
+    auto ctxloop = ioctx->startContextLoop();
+    auto server = startEchoServer(ioctx);
+    auto pool = TcpConnectionPool::create(ioctx->getBaseContext());
+
+    auto first = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(first);
+    CHECK(request(pool, first, "request", true) == "request");
+    REQUIRE(waitFor([&pool]() { return pool->idleCount() == 1; }));
+    auto connection = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(connection);
+    CHECK(connection == first);
+    first.reset();
+
+    connection->setDataCall(
+        [](const TcpConnection::pointer&, const char*, size_t datasize) {
+            return datasize;
+        });
+    // the read is pending once the loop is started
+    connection->startReceive();
+    CHECK(connection->isReceiving());
+
+    // hold the context so the aborted read handler can't run
+    std::promise<void> release;
+    std::promise<void> holding;
+    auto released = release.get_future().share();
+    asio::post(ioctx->getBaseContext(), [&holding, released]() {
+        holding.set_value();
+        released.wait();
+    });
+    holding.get_future().wait();
+
+    connection->closeNoWait();
+    CHECK_FALSE(connection->waitOnClose(
+        std::chrono::steady_clock::now() + 200ms));
+    release.set_value();
+    CHECK(connection->waitOnClose(std::chrono::steady_clock::now() + 5s));
+    CHECK_FALSE(connection->isReceiving());
+
+    pool->closeAll();
+    server->close();
+}
+
+TEST_CASE("separateSettingsTest", "[connectionPool]")
+{
+    auto ioctx = gmlc::networking::AsioContextManager::getContextPointer(
+        "connectionPool");
+    auto ctxloop = ioctx->startContextLoop();
+    auto server = startEchoServer(ioctx);
+    auto pool = TcpConnectionPool::create(ioctx->getBaseContext());
+
+    SocketFactory serverRole;
+    serverRole.set_handshake_server(true);
+    CHECK(serverRole.get_settings_key() != SocketFactory().get_settings_key());
+
+    auto first = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(first);
+    CHECK(pool->checkin(first));
+    REQUIRE(waitFor([&pool]() { return pool->idleCount() == 1; }));
+    // different settings never share a connection
+    auto second = pool->checkout(serverRole, "localhost", "19888", 5000ms);
+    REQUIRE(second);
+    CHECK(second != first);
+    CHECK(pool->idleCount() == 1);
+    CHECK(pool->getStatistics().created == 2);
+    second->close();
+    pool->closeAll();
+    server->close();
+}
+
+TEST_CASE("closedByServerTest", "[connectionPool]")
+{
+    auto ioctx = gmlc::networking::AsioContextManager::getContextPointer(
+        "connectionPool");
+    auto ctxloop = ioctx->startContextLoop();
+    auto server = startEchoServer(ioctx);
+    auto pool = TcpConnectionPool::create(ioctx->getBaseContext());
+
+    auto first = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(first);
+    CHECK(request(pool, first, "request", true) == "request");
+    REQUIRE(waitFor([&pool]() { return pool->idleCount() == 1; }));
+
+    // the idle connection notices the server going away
+    server->close();
+    server.reset();
+    CHECK(waitFor([&first]() { return !first->isReceiving(); }));
+    CHECK(pool->evictIdle() == 1);
+    CHECK(pool->idleCount() == 0);
+    CHECK(pool->getStatistics().evicted == 1);
+
+    // an unhealthy connection still in the pool is never handed out
+    server = startEchoServer(ioctx);
+    auto second = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(second);
+    CHECK(pool->checkin(second));
+    REQUIRE(waitFor([&pool]() { return pool->idleCount() == 1; }));
+    server->close();
+    server.reset();
+    CHECK(waitFor([&second]() { return !second->isReceiving(); }));
+    server = startEchoServer(ioctx);
+    auto third = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(third);
+    CHECK(third != second);
+    CHECK(request(pool, third, "again", false) == "again");
+    auto stats = pool->getStatistics();
+    CHECK(stats.created == 3);
+    CHECK(stats.reused == 0);
+    CHECK(stats.discarded == 1);
+    third->close();
+    // a closed connection is not kept
+    CHECK_FALSE(pool->checkin(third));
+    CHECK(pool->idleCount() == 0);
+    server->close();
+}
+
+TEST_CASE("idleTimeoutTest", "[connectionPool]")
+{
+    auto ioctx = gmlc::networking::AsioContextManager::getContextPointer(
+        "connectionPool");
+    auto ctxloop = ioctx->startContextLoop();
+    auto server = startEchoServer(ioctx);
+    auto pool = TcpConnectionPool::create(ioctx->getBaseContext(), 100ms, 1);
+
+    auto first = pool->checkout("localhost", "19888", 5000ms);
+    auto second = pool->checkout("localhost", "19888", 5000ms);
+    REQUIRE(first);
+    REQUIRE(second);
+    CHECK(pool->checkin(first));
+    CHECK(pool->checkin(second));
+    // only one idle connection is kept for the endpoint
+    REQUIRE(waitFor(
+        [&pool]() { return pool->getStatistics().returned == 2; }));
+    CHECK(pool->idleCount() == 1);
+    CHECK(pool->getStatistics().evicted == 1);
+
+    // the timer closes the connection once it has been idle too long
+    CHECK(waitFor([&pool]() { return pool->idleCount() == 0; }));
+    CHECK(pool->getStatistics().evicted == 2);
+    CHECK(waitFor([&first, &second]() {
+        return !first->socket()->is_open() && !second->socket()->is_open();
+    }));
+    server->close();
+}
+
+TEST_CASE("checkoutFailureTest", "[connectionPool]")
+{
+    auto ioctx = gmlc::networking::AsioContextManager::getContextPointer(
+        "connectionPool");
+    auto ctxloop = ioctx->startContextLoop();
+    auto pool = TcpConnectionPool::create(ioctx->getBaseContext());
+    CHECK_THROWS_AS(
+        pool->checkout("127.0.0.1", "19887", 0ms), std::system_error);
+
+    std::promise<std::error_code> failure;
+    pool->checkoutAsync(
+        SocketFactory(),
+        "127.0.0.1",
+        "19887",
+        0ms,
+        [&failure](
+            const TcpConnection::pointer& connection,
+            const std::error_code& error) {
+            CHECK_FALSE(connection);
+            failure.set_value(error);
+        });
+    auto result = failure.get_future();
+    REQUIRE(result.wait_for(5s) == std::future_status::ready);
+    CHECK(result.get() == asio::error::connection_refused);
+    CHECK(pool->getStatistics().created == 0);
+}
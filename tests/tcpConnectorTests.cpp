@@ -0,0 +1,163 @@
+/*
+Copyright (c) 2017-2022,
+Battelle Memorial Institute; Lawrence Livermore National Security, LLC; Alliance
+for Sustainable Energy, LLC.  See the top-level NOTICE for additional details.
+All rights reserved. SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+#include "gmlc/networking/TcpConnector.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace gmlc::networking;
+using namespace std::chrono_literals;  // NOLINT
+using asio::ip::tcp;
+
+namespace {
+tcp::endpoint makeEndpoint(const std::string& address, unsigned short port)
+{
+    return {asio::ip::make_address(address), port};
+}
+
+/** the outcome of a connection attempt*/
+struct ConnectResult {
+    int calls{0};
+    std::error_code error;
+    tcp::endpoint remote;
+    std::chrono::steady_clock::duration elapsed{};
+};
+
+ConnectResult runConnect(
+    asio::io_context& ioctx,
+    const std::shared_ptr<TcpConnector>& connector,
+    const std::vector<tcp::endpoint>& endpoints)
+{
+    ConnectResult result;
+    const auto start = std::chrono::steady_clock::now();
+    connector->asyncConnect(
+        endpoints,
+        [&result, start](const std::error_code& error, tcp::socket socket) {
+            ++result.calls;
+            result.error = error;
+            result.elapsed = std::chrono::steady_clock::now() - start;
+            if (!error) {
+                result.remote = socket.remote_endpoint();
+            }
+        });
+    ioctx.restart();
+    ioctx.run_for(10s);
+    return result;
+}
+}  // namespace
+
+TEST_CASE("orderEndpointsTest", "[tcpConnector]")
+{
+    const std::vector<tcp::endpoint> endpoints{
+        makeEndpoint("::1", 1),
+        makeEndpoint("fe80::1", 2),
+        makeEndpoint("127.0.0.1", 3),
+        makeEndpoint("::2", 4),
+        makeEndpoint("127.0.0.2", 5),
+    };
+    auto ordered = TcpConnector::orderEndpoints(endpoints);
+    REQUIRE(ordered.size() == endpoints.size());
+    // the families alternate starting with the first, each keeps its order
+    CHECK(ordered[0].port() == 1);
+    CHECK(ordered[1].port() == 3);
+    CHECK(ordered[2].port() == 2);
+    CHECK(ordered[3].port() == 5);
+    CHECK(ordered[4].port() == 4);
+    CHECK(TcpConnector::orderEndpoints({}).empty());
+}
+
+TEST_CASE("connectAfterRefusedTest", "[tcpConnector]")
+{
+    asio::io_context ioctx;
+    tcp::acceptor acceptor(ioctx, makeEndpoint("127.0.0.1", 19888));
+    auto connector = TcpConnector::create(ioctx, 5s);
+    // a refused attempt moves on without waiting for the attempt delay
+    auto result = runConnect(
+        ioctx,
+        connector,
+        {makeEndpoint("127.0.0.1", 19887), makeEndpoint("127.0.0.1", 19888)});
+    CHECK(result.calls == 1);
+    CHECK_FALSE(result.error);
+    CHECK(result.remote.port() == 19888);
+    CHECK(result.elapsed < 2s);
+    CHECK(connector->attemptCount() == 2);
+}
+
+TEST_CASE("connectPastStalledTest", "[tcpConnector]")
+{
+    asio::io_context ioctx;
+    tcp::acceptor acceptor(ioctx, makeEndpoint("127.0.0.1", 19888));
+    // a listener with a full backlog drops new connection requests so
+    // connecting to it stalls
+    tcp::acceptor stalled(ioctx);
+    stalled.open(tcp::v4());
+    stalled.bind(makeEndpoint("127.0.0.1", 19886));
+    stalled.listen(0);
+    tcp::socket queued(ioctx);
+    queued.connect(makeEndpoint("127.0.0.1", 19886));
+
+    constexpr auto attemptDelay{100ms};
+    auto connector = TcpConnector::create(ioctx, attemptDelay);
+    auto result = runConnect(
+        ioctx,
+        connector,
+        {makeEndpoint("127.0.0.1", 19886), makeEndpoint("127.0.0.1", 19888)});
+    CHECK(result.calls == 1);
+    CHECK_FALSE(result.error);
+    CHECK(result.remote == makeEndpoint("127.0.0.1", 19888));
+    // the second attempt starts after the delay instead of the connect
+    // timeout of the first
+    CHECK(result.elapsed >= attemptDelay);
+    CHECK(result.elapsed < 2s);
+    CHECK(connector->attemptCount() == 2);
+}
+
+TEST_CASE("allAttemptsFailTest", "[tcpConnector]")
+{
+    asio::io_context ioctx;
+    auto connector = TcpConnector::create(ioctx);
+    auto result = runConnect(
+        ioctx,
+        connector,
+        {makeEndpoint("127.0.0.1", 19887), makeEndpoint("127.0.0.1", 19887)});
+    CHECK(result.calls == 1);
+    CHECK(result.error == asio::error::connection_refused);
+    CHECK(connector->attemptCount() == 2);
+
+    // nothing to connect to
+    auto empty = runConnect(ioctx, TcpConnector::create(ioctx), {});
+    CHECK(empty.calls == 1);
+    CHECK(empty.error == asio::error::host_not_found);
+
+    // a connector is only used once
+    auto reused = runConnect(ioctx, connector, {makeEndpoint("127.0.0.1", 1)});
+    CHECK(reused.calls == 1);
+    CHECK(reused.error == asio::error::operation_aborted);
+}
+
+TEST_CASE("cancelConnectTest", "[tcpConnector]")
+{
+    asio::io_context ioctx;
+    auto connector = TcpConnector::create(ioctx);
+    int calls{0};
+    std::error_code result;
+    connector->asyncConnect(
+        {makeEndpoint("192.0.2.1", 19888)},
+        [&calls, &result](const std::error_code& error, tcp::socket) {
+            ++calls;
+            result = error;
+        });
+    connector->cancel();
+    connector->cancel();
+    ioctx.run_for(5s);
+    CHECK(calls == 1);
+    CHECK(result == asio::error::operation_aborted);
+}
@@ -7,10 +7,20 @@ All rights reserved. SPDX-License-Identifier: BSD-3-Clause
 
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
+#include <algorithm>
+#include <asio/post.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <set>
 #include <stdlib.h>
+#include <string>
 #include <thread>
 
 #include "gmlc/networking/AsioContextManager.h"
+#include "gmlc/networking/AsioContextPool.h"
 #include "gmlc/networking/TcpOperations.h"
 #include "gmlc/networking/addressOperations.hpp"
 #include "gmlc/networking/interfaceOperations.hpp"
@@ -165,3 +175,1481 @@ TEST_CASE("TcpOperationsTest", "[TcpOps]")
 
     CHECK(data_recv_size == 5);
 }
+
+TEST_CASE("mirroredReceiveBufferTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true);
+    REQUIRE(spt->isReady());
+    spt->setReceiveBufferMode(TcpConnection::ReceiveBufferMode::MIRRORED);
+
+    // fixed size records that never line up with the ring boundary
+    constexpr size_t recordSize = 7;
+    constexpr int recordCount = 5000;
+    std::atomic<int> records{0};
+    std::atomic<int> badRecords{0};
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer&,
+                         const char* data,
+                         size_t datasize) {
+        size_t used = 0;
+        while (datasize - used >= recordSize) {
+            auto expected = std::to_string(1000000 + records.load());
+            if (std::string(data + used, recordSize) != expected) {
+                ++badRecords;
+            }
+            ++records;
+            used += recordSize;
+        }
+        return used;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+
+    std::string stream;
+    for (int ii = 0; ii < recordCount; ++ii) {
+        stream.append(std::to_string(1000000 + ii));
+    }
+    size_t offset = 0;
+    size_t chunk = 1;
+    while (offset < stream.size()) {
+        auto len = (std::min)(chunk, stream.size() - offset);
+        cpt->send(stream.data() + offset, len);
+        offset += len;
+        chunk = (chunk * 7 + 3) % 4099 + 1;
+    }
+    int itCount{0};
+    while (records.load() < recordCount && itCount++ < 50) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    spt->close();
+    cpt->close();
+
+    CHECK(records.load() == recordCount);
+    CHECK(badRecords.load() == 0);
+}
+
+TEST_CASE("growingReceiveBufferTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+
+    constexpr size_t messageSize = 100000;
+    std::atomic<size_t> received{0};
+    std::atomic<size_t> capacity{0};
+    // only accept the message once all of it is available
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer& conn,
+                         const char* data,
+                         size_t datasize) {
+        if (datasize < messageSize) {
+            return size_t{0};
+        }
+        CHECK(data[messageSize - 1] == 'z');
+        capacity = conn->getBufferCapacity();
+        received = datasize;
+        return datasize;
+    });
+    spt->setErrorCall([](const gmlc::networking::TcpConnection::pointer&,
+                         const std::error_code& error) {
+        INFO("Error (" << error.value() << "): " << error.message());
+        CHECK(false);
+        return false;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    std::string message(messageSize, 'a');
+    message.back() = 'z';
+    cpt->send(message);
+
+    int itCount{0};
+    while (received.load() == 0 && itCount++ < 50) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    spt->close();
+    cpt->close();
+    CHECK(received.load() == messageSize);
+    CHECK(capacity.load() >= messageSize);
+}
+
+TEST_CASE("zeroSizeReceiveBufferTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    // accepted connections start without any receive space
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 0);
+    REQUIRE(spt->isReady());
+    CHECK_THROWS_AS(spt->setMaxBufferSize(0), std::runtime_error);
+
+    const std::string message("zero size buffer");
+    std::atomic<size_t> received{0};
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer&,
+                         const char* /*data*/,
+                         size_t datasize) {
+        if (datasize < message.size()) {
+            return size_t{0};
+        }
+        received = datasize;
+        return datasize;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    cpt->send(message);
+
+    int itCount{0};
+    while (received.load() == 0 && itCount++ < 50) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    spt->close();
+    cpt->close();
+    CHECK(received.load() == message.size());
+}
+
+TEST_CASE("receiveBufferLimitTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setMaxBufferSize(4096);
+
+    std::atomic<bool> overflow{false};
+    spt->setDataCall([](const gmlc::networking::TcpConnection::pointer&,
+                        const char* /*data*/,
+                        size_t /*datasize*/) { return size_t{0}; });
+    spt->setErrorCall([&](const gmlc::networking::TcpConnection::pointer&,
+                          const std::error_code& error) {
+        if (error == asio::error::message_size) {
+            overflow = true;
+        }
+        return false;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    cpt->send(std::string(10000, 'a'));
+
+    int itCount{0};
+    while (!overflow.load() && itCount++ < 50) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    spt->close();
+    cpt->close();
+    CHECK(overflow.load());
+}
+
+TEST_CASE("framedMessageTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setFramingMode(FramingMode::VARINT);
+
+    constexpr int messageCount = 200;
+    std::atomic<int> received{0};
+    std::atomic<bool> valid{true};
+    // message i has a length of i*37 with all bytes equal to i
+    spt->setMessageCall([&](const gmlc::networking::TcpConnection::pointer&,
+                            const char* message,
+                            size_t length) {
+        const int index = received.load();
+        if (length != static_cast<size_t>(index) * 37 ||
+            std::any_of(message, message + length, [index](char value) {
+                return value != static_cast<char>(index);
+            })) {
+            valid = false;
+        }
+        ++received;
+    });
+    spt->setErrorCall([](const gmlc::networking::TcpConnection::pointer&,
+                         const std::error_code& error) {
+        INFO("Error (" << error.value() << "): " << error.message());
+        CHECK(false);
+        return false;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    cpt->setFramingMode(FramingMode::VARINT);
+    for (int ii = 0; ii < messageCount; ++ii) {
+        cpt->sendMessage(
+            std::string(static_cast<size_t>(ii) * 37, static_cast<char>(ii)));
+    }
+
+    int itCount{0};
+    while (received.load() < messageCount && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    spt->close();
+    cpt->close();
+    CHECK(received.load() == messageCount);
+    CHECK(valid.load());
+}
+
+TEST_CASE("concurrentFramedMessageTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setFramingMode(FramingMode::VARINT);
+
+    constexpr int threadCount = 4;
+    constexpr int messageCount = 50;
+    // large enough to be written in several parts
+    constexpr size_t messageSize = 256 * 1024;
+    std::atomic<int> received{0};
+    std::atomic<bool> valid{true};
+    // each message is a single repeated character so a header and body split
+    // by another sender shows up as a bad message
+    spt->setMessageCall([&](const gmlc::networking::TcpConnection::pointer&,
+                            const char* message,
+                            size_t length) {
+        if (length != messageSize ||
+            std::any_of(message, message + length, [message](char value) {
+                return value != message[0];
+            })) {
+            valid = false;
+        }
+        ++received;
+    });
+    spt->setErrorCall([&valid](
+                          const gmlc::networking::TcpConnection::pointer&,
+                          const std::error_code&) {
+        valid = false;
+        return false;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    cpt->setFramingMode(FramingMode::VARINT);
+    std::atomic<int> sendFailures{0};
+    std::vector<std::thread> senders;
+    for (int ii = 0; ii < threadCount; ++ii) {
+        senders.emplace_back([&cpt, &sendFailures, ii]() {
+            const std::string message(messageSize, static_cast<char>('a' + ii));
+            for (int jj = 0; jj < messageCount; ++jj) {
+                if (cpt->sendMessage(message) != messageSize) {
+                    ++sendFailures;
+                }
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    CHECK(sendFailures.load() == 0);
+
+    int itCount{0};
+    while (received.load() < threadCount * messageCount && itCount++ < 250) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    spt->close();
+    cpt->close();
+    CHECK(received.load() == threadCount * messageCount);
+    CHECK(valid.load());
+}
+
+TEST_CASE("asyncSendQueueTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+
+    constexpr int threadCount = 4;
+    constexpr int messageCount = 2000;
+    constexpr size_t recordSize = 16;
+    std::atomic<size_t> records{0};
+    std::atomic<bool> interleaved{false};
+    // each record is made of a single repeated character so any interleaving
+    // between senders shows up as a mixed record
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer&,
+                         const char* data,
+                         size_t datasize) {
+        size_t used{0};
+        while (datasize - used >= recordSize) {
+            if (std::any_of(
+                    data + used, data + used + recordSize, [data, used](char c) {
+                        return c != data[used];
+                    })) {
+                interleaved = true;
+            }
+            used += recordSize;
+            ++records;
+        }
+        return used;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    std::atomic<int> completions{0};
+    std::atomic<size_t> batchMessages{0};
+    cpt->setSendCompletionCall(
+        [&batchMessages](
+            const gmlc::networking::TcpConnection::pointer&,
+            const std::error_code& error,
+            size_t messages,
+            size_t /*bytes*/) {
+            CHECK(!error);
+            batchMessages += messages;
+        });
+
+    std::vector<std::thread> senders;
+    for (int ii = 0; ii < threadCount; ++ii) {
+        senders.emplace_back([&cpt, &completions, ii]() {
+            for (int jj = 0; jj < messageCount; ++jj) {
+                cpt->asyncSend(
+                    std::string(recordSize, static_cast<char>('a' + ii)),
+                    [&completions](const std::error_code& error, size_t size) {
+                        if (!error && size == recordSize) {
+                            ++completions;
+                        }
+                    });
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+
+    int itCount{0};
+    while ((records.load() < threadCount * messageCount ||
+            cpt->getPendingSendCount() > 0) &&
+           itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(records.load() == threadCount * messageCount);
+    CHECK(!interleaved.load());
+    CHECK(completions.load() == threadCount * messageCount);
+    CHECK(batchMessages.load() == threadCount * messageCount);
+    CHECK(cpt->getPendingSendCount() == 0);
+    spt->close();
+    cpt->close();
+}
+
+TEST_CASE("mixedBlockingAsyncSendTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 65536);
+    REQUIRE(spt->isReady());
+
+    constexpr std::uint32_t messageCount = 500;
+    constexpr size_t recordSize = 8192;
+    constexpr char blockingId{'b'};
+    constexpr char asyncId{'a'};
+    std::atomic<size_t> records{0};
+    std::atomic<int> corrupted{0};
+    std::atomic<int> outOfOrder{0};
+    std::uint32_t nextBlocking{0};
+    std::uint32_t nextAsync{0};
+    // each record is a sender id, a sequence number, and filler made of the
+    // sender id so any interleaving of the two streams breaks a record
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer&,
+                         const char* data,
+                         size_t datasize) {
+        size_t used{0};
+        while (datasize - used >= recordSize) {
+            const char* record = data + used;
+            const char id = record[0];
+            std::uint32_t sequence{0};
+            std::memcpy(&sequence, record + 1, sizeof(sequence));
+            const bool filled = std::all_of(
+                record + 1 + sizeof(sequence),
+                record + recordSize,
+                [id](char c) { return c == id; });
+            if (!filled || (id != blockingId && id != asyncId)) {
+                ++corrupted;
+            } else {
+                auto& expected = (id == blockingId) ? nextBlocking : nextAsync;
+                if (sequence != expected) {
+                    ++outOfOrder;
+                }
+                expected = sequence + 1;
+            }
+            used += recordSize;
+            ++records;
+        }
+        return used;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+
+    auto makeRecord = [](char id, std::uint32_t sequence) {
+        std::string record(recordSize, id);
+        std::memcpy(&record[1], &sequence, sizeof(sequence));
+        return record;
+    };
+    std::atomic<int> sendFailures{0};
+    std::thread blockingSender([&]() {
+        for (std::uint32_t ii = 0; ii < messageCount; ++ii) {
+            if (cpt->send(makeRecord(blockingId, ii)) != recordSize) {
+                ++sendFailures;
+            }
+        }
+    });
+    std::thread asyncSender([&]() {
+        for (std::uint32_t ii = 0; ii < messageCount; ++ii) {
+            cpt->asyncSend(
+                makeRecord(asyncId, ii),
+                [&sendFailures](const std::error_code& error, size_t size) {
+                    if (error || size != recordSize) {
+                        ++sendFailures;
+                    }
+                });
+        }
+    });
+    blockingSender.join();
+    asyncSender.join();
+
+    int itCount{0};
+    while ((records.load() < 2 * messageCount ||
+            cpt->getPendingSendCount() > 0) &&
+           itCount++ < 200) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(records.load() == 2 * messageCount);
+    CHECK(corrupted.load() == 0);
+    CHECK(outOfOrder.load() == 0);
+    CHECK(sendFailures.load() == 0);
+    CHECK(cpt->getPendingSendCount() == 0);
+    spt->close();
+    cpt->close();
+    CHECK(nextBlocking == messageCount);
+    CHECK(nextAsync == messageCount);
+}
+
+TEST_CASE("multiThreadedContextTest", "[TcpOps]")
+{
+    auto io_context_threaded =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_threaded");
+    io_context_threaded->setThreadCount(4);
+    auto context_loop = io_context_threaded->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_threaded->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+
+    constexpr int clientCount = 4;
+    constexpr int messageCount = 1000;
+    constexpr size_t recordSize = 16;
+    std::atomic<size_t> records{0};
+    std::atomic<bool> overlapped{false};
+    std::mutex activeLock;
+    std::set<int> active;
+    // the callbacks for a single connection run on its strand so they must
+    // never overlap, even with several threads running the context
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer& conn,
+                         const char* /*data*/,
+                         size_t datasize) {
+        {
+            std::lock_guard<std::mutex> lock(activeLock);
+            if (!active.insert(conn->getIdentifier()).second) {
+                overlapped = true;
+            }
+        }
+        std::this_thread::yield();
+        size_t used = datasize - datasize % recordSize;
+        records += used / recordSize;
+        {
+            std::lock_guard<std::mutex> lock(activeLock);
+            active.erase(conn->getIdentifier());
+        }
+        return used;
+    });
+    spt->start();
+
+    std::vector<TcpConnection::pointer> clients;
+    for (int ii = 0; ii < clientCount; ++ii) {
+        auto cpt = establishConnection(
+            io_context_threaded->getBaseContext(),
+            std::string("localhost"),
+            "19888",
+            std::chrono::milliseconds(1000));
+        REQUIRE(cpt);
+        REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+        clients.push_back(std::move(cpt));
+    }
+    for (int jj = 0; jj < messageCount; ++jj) {
+        for (auto& cpt : clients) {
+            cpt->asyncSend(std::string(recordSize, 'a'));
+        }
+    }
+
+    int itCount{0};
+    while (records.load() < clientCount * messageCount && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(records.load() == clientCount * messageCount);
+    CHECK_FALSE(overlapped.load());
+    for (auto& cpt : clients) {
+        cpt->close();
+    }
+    spt->close();
+}
+
+TEST_CASE("zeroCopySendTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 4096);
+    REQUIRE(spt->isReady());
+
+    constexpr size_t largeSize = 1024 * 1024;
+    constexpr size_t smallSize = 100;
+    constexpr size_t totalSize = 3 * largeSize + 2 * smallSize;
+    std::atomic<size_t> received{0};
+    std::atomic<bool> valid{true};
+    // every byte is the low byte of its position in the stream
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer&,
+                         const char* data,
+                         size_t datasize) {
+        auto offset = received.load();
+        for (size_t ii = 0; ii < datasize; ++ii) {
+            if (data[ii] != static_cast<char>((offset + ii) & 0xFFU)) {
+                valid = false;
+            }
+        }
+        received += datasize;
+        return datasize;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    // zero copy is only available on linux, elsewhere the same calls fall
+    // back to normal writes
+    auto zeroCopy = cpt->setZeroCopyThreshold(64 * 1024);
+#ifdef __linux__
+    CHECK(zeroCopy);
+#else
+    CHECK(!zeroCopy);
+#endif
+
+    std::string stream(totalSize, '\0');
+    for (size_t ii = 0; ii < totalSize; ++ii) {
+        stream[ii] = static_cast<char>(ii & 0xFFU);
+    }
+    std::atomic<int> released{0};
+    std::atomic<int> completed{0};
+    auto onComplete = [&completed](const std::error_code& error, size_t) {
+        CHECK(!error);
+        ++completed;
+    };
+    size_t position{0};
+    for (auto size : {largeSize, smallSize, largeSize, smallSize, largeSize}) {
+        if (size == largeSize) {
+            cpt->asyncSendZeroCopy(
+                stream.data() + position, size, onComplete, [&released]() {
+                    ++released;
+                });
+        } else {
+            cpt->asyncSend(stream.substr(position, size), onComplete);
+        }
+        position += size;
+    }
+
+    int itCount{0};
+    while ((received.load() < totalSize || released.load() < 3) &&
+           itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(received.load() == totalSize);
+    CHECK(valid.load());
+    CHECK(completed.load() == 5);
+    CHECK(released.load() == 3);
+    spt->close();
+    cpt->close();
+}
+
+TEST_CASE("speculativeReadTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 4096);
+    REQUIRE(spt->isReady());
+    spt->setReadBudget(16);
+
+    constexpr size_t totalSize = 8 * 1024 * 1024;
+    std::atomic<size_t> received{0};
+    std::atomic<bool> valid{true};
+    TcpConnection::pointer serverConnection;
+    std::mutex connectionLock;
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer& conn,
+                         const char* data,
+                         size_t datasize) {
+        auto offset = received.load();
+        if (offset == 0) {
+            std::lock_guard<std::mutex> lock(connectionLock);
+            serverConnection = conn;
+        }
+        for (size_t ii = 0; ii < datasize; ++ii) {
+            if (data[ii] != static_cast<char>((offset + ii) % 251)) {
+                valid = false;
+            }
+        }
+        received += datasize;
+        return datasize;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    std::string chunk(65536, '\0');
+    for (size_t sent = 0; sent < totalSize; sent += chunk.size()) {
+        for (size_t ii = 0; ii < chunk.size(); ++ii) {
+            chunk[ii] = static_cast<char>((sent + ii) % 251);
+        }
+        cpt->send(chunk);
+    }
+
+    int itCount{0};
+    while (received.load() < totalSize && itCount++ < 200) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(received.load() == totalSize);
+    CHECK(valid.load());
+    {
+        std::lock_guard<std::mutex> lock(connectionLock);
+        REQUIRE(serverConnection);
+        CHECK(serverConnection->getReadBudget() == 16);
+        CHECK(serverConnection->getAsyncReadCount() > 0);
+        // every byte is consumed so no read can exceed the 4096 byte buffer
+        CHECK(
+            serverConnection->getAsyncReadCount() +
+                serverConnection->getSpeculativeReadCount() >=
+            totalSize / 4096);
+        serverConnection.reset();
+    }
+    spt->close();
+    cpt->close();
+}
+
+TEST_CASE("connectionStatisticsTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+
+    constexpr size_t messageCount = 100;
+    constexpr size_t messageSize = 50;
+    std::atomic<size_t> received{0};
+    // only consume complete messages so partial ones are carried over
+    spt->setDataCall([&received](
+                         const gmlc::networking::TcpConnection::pointer&,
+                         const char* /*data*/,
+                         size_t datasize) {
+        auto used = (datasize / messageSize) * messageSize;
+        received += used;
+        return used;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    const std::string message(messageSize, 's');
+    for (size_t ii = 0; ii < messageCount; ++ii) {
+        cpt->send(message);
+    }
+
+    int itCount{0};
+    while (received.load() < messageCount * messageSize && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE(received.load() == messageCount * messageSize);
+
+    auto clientStats = cpt->getStatistics();
+    CHECK(clientStats.bytesSent == messageCount * messageSize);
+    CHECK(clientStats.messagesSent == messageCount);
+    CHECK(clientStats.errors == 0);
+
+    auto serverStats = spt->getStatistics();
+    CHECK(serverStats.bytesReceived == messageCount * messageSize);
+    CHECK(serverStats.messagesReceived >= serverStats.asyncReads);
+    CHECK(serverStats.asyncReads > 0);
+    CHECK(serverStats.errors == 0);
+
+    auto perConnection = spt->getConnectionStatistics();
+    REQUIRE(perConnection.size() == 1);
+    CHECK(
+        perConnection.front().second.bytesReceived ==
+        messageCount * messageSize);
+    spt->close();
+    cpt->close();
+}
+
+TEST_CASE("latencyHistogramTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto histograms = io_context_server->enableLatencyHistograms();
+    histograms->reset();
+    CHECK(io_context_server->getLatencyHistograms() == histograms);
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setLatencyHistograms(histograms);
+
+    constexpr size_t messageCount = 50;
+    std::atomic<size_t> received{0};
+    spt->setDataCall([&received](
+                         const gmlc::networking::TcpConnection::pointer&,
+                         const char* /*data*/,
+                         size_t datasize) {
+        received += datasize;
+        return datasize;
+    });
+    spt->start();
+
+    auto cpt = establishConnection(
+        io_context_server->getBaseContext(),
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    auto clientHistograms = std::make_shared<LatencyHistograms>();
+    cpt->setLatencyHistograms(clientHistograms);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    const std::string message(100, 'h');
+    for (size_t ii = 0; ii < messageCount; ++ii) {
+        cpt->send(message);
+    }
+
+    int itCount{0};
+    while (received.load() < messageCount * message.size() && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE(received.load() == messageCount * message.size());
+    auto callbacks = spt->getStatistics().messagesReceived;
+    // the time of the last callback is recorded after it returns
+    itCount = 0;
+    while (latencyHistogramsEnabled &&
+           histograms->callback.count() < callbacks && itCount++ < 50) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (latencyHistogramsEnabled) {
+        CHECK(clientHistograms->send.count() == messageCount);
+        CHECK(histograms->callback.count() == callbacks);
+        CHECK(histograms->dispatch.count() == callbacks);
+        CHECK(
+            histograms->callback.percentile(0.5) <=
+            histograms->callback.percentile(0.999));
+    } else {
+        CHECK(clientHistograms->send.count() == 0);
+        CHECK(histograms->callback.count() == 0);
+    }
+    CHECK(clientHistograms->callback.count() == 0);
+    spt->close();
+    cpt->close();
+}
+
+TEST_CASE("closeAllTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setDataCall([](const gmlc::networking::TcpConnection::pointer&,
+                        const char* /*data*/,
+                        size_t datasize) { return datasize; });
+    spt->start();
+
+    constexpr size_t clientCount{8};
+    std::vector<TcpConnection::pointer> clients;
+    for (size_t ii = 0; ii < clientCount; ++ii) {
+        auto cpt = establishConnection(
+            io_context_server->getBaseContext(),
+            std::string("localhost"),
+            "19888",
+            std::chrono::milliseconds(1000));
+        REQUIRE(cpt);
+        REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+        clients.push_back(std::move(cpt));
+    }
+    int itCount{0};
+    while (spt->getConnectionStatistics().size() < clientCount &&
+           itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(spt->getConnectionStatistics().size() == clientCount);
+
+    auto summary = spt->closeAll(
+        std::chrono::steady_clock::now() + std::chrono::seconds(5));
+    CHECK(summary.closed == clientCount);
+    CHECK(summary.timedOut == 0);
+    CHECK(summary.elapsed < std::chrono::seconds(5));
+    CHECK(spt->getConnectionStatistics().empty());
+    // the server still accepts connections after closing the current ones
+    CHECK(spt->isReady());
+    for (auto& cpt : clients) {
+        CHECK(
+            cpt->waitOnClose(
+                std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+    }
+    spt->close();
+}
+
+TEST_CASE("concurrentFindSocketTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setDataCall([](const gmlc::networking::TcpConnection::pointer&,
+                        const char* /*data*/,
+                        size_t datasize) { return datasize; });
+    spt->start();
+
+    constexpr size_t clientCount{8};
+    std::vector<TcpConnection::pointer> clients;
+    for (size_t ii = 0; ii < clientCount; ++ii) {
+        auto cpt = establishConnection(
+            io_context_server->getBaseContext(),
+            std::string("localhost"),
+            "19888",
+            std::chrono::milliseconds(1000));
+        REQUIRE(cpt);
+        REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+        clients.push_back(std::move(cpt));
+    }
+    int itCount{0};
+    while (spt->getConnectionStatistics().size() < clientCount &&
+           itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto stats = spt->getConnectionStatistics();
+    REQUIRE(stats.size() == clientCount);
+    CHECK(std::is_sorted(
+        stats.begin(), stats.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        }));
+
+    std::vector<int> ids;
+    for (const auto& stat : stats) {
+        ids.push_back(stat.first);
+    }
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int ii = 0; ii < 4; ++ii) {
+        readers.emplace_back([&spt, &ids, &mismatches]() {
+            for (int jj = 0; jj < 1000; ++jj) {
+                for (auto id : ids) {
+                    auto conn = spt->findSocket(id);
+                    if (!conn || conn->getIdentifier() != id) {
+                        ++mismatches;
+                    }
+                }
+                // statistics iterate the table while the lookups run
+                if (spt->getConnectionStatistics().size() != ids.size()) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK(mismatches.load() == 0);
+    CHECK(!spt->findSocket(ids.back() + 1000));
+
+    spt->closeAll(std::chrono::steady_clock::now() + std::chrono::seconds(5));
+    CHECK(!spt->findSocket(ids.front()));
+    for (auto& cpt : clients) {
+        cpt->close();
+    }
+    spt->close();
+}
+
+TEST_CASE("closeAllDeadlineTest", "[TcpOps]")
+{
+    asio::io_context context;
+    auto work = asio::make_work_guard(context);
+    std::thread runner([&context]() { context.run(); });
+
+    auto spt = TcpServer::create(context, "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setDataCall([](const gmlc::networking::TcpConnection::pointer&,
+                        const char* /*data*/,
+                        size_t datasize) { return datasize; });
+    spt->start();
+    auto cpt = establishConnection(
+        context,
+        std::string("localhost"),
+        "19888",
+        std::chrono::milliseconds(1000));
+    REQUIRE(cpt);
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    int itCount{0};
+    while (spt->getConnectionStatistics().empty() && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(spt->getConnectionStatistics().size() == 1);
+
+    // with the context stopped the aborted read is never processed
+    context.stop();
+    runner.join();
+    auto summary = spt->closeAll(
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+    CHECK(summary.closed == 0);
+    CHECK(summary.timedOut == 1);
+    CHECK(summary.elapsed >= std::chrono::milliseconds(90));
+
+    context.restart();
+    std::thread finisher([&context]() { context.run(); });
+    cpt->close();
+    spt->close();
+    work.reset();
+    finisher.join();
+}
+
+TEST_CASE("sendBeforeConnectedTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    std::mutex receivedLock;
+    std::string received;
+    spt->setDataCall([&](const gmlc::networking::TcpConnection::pointer&,
+                         const char* data,
+                         size_t datasize) {
+        std::lock_guard<std::mutex> lock(receivedLock);
+        received.append(data, datasize);
+        return datasize;
+    });
+    spt->start();
+
+    // the client context is not running so the connection cannot complete
+    // until everything has been queued
+    asio::io_context context;
+    auto cpt = TcpConnection::create(context, "localhost", "19888", 1024);
+    CHECK_FALSE(cpt->isConnected());
+    std::string expected;
+    for (int ii = 0; ii < 20; ++ii) {
+        auto message = "message" + std::to_string(ii) + ";";
+        if (ii % 2 == 0) {
+            CHECK(cpt->send(message) == message.size());
+        } else {
+            cpt->asyncSend(message);
+        }
+        expected += message;
+    }
+    CHECK(cpt->getPendingSendCount() == 20);
+
+    std::thread runner([&context]() { context.run(); });
+    REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+    // sends right after connecting still go behind the queued data
+    cpt->send(std::string("last"));
+    expected += "last";
+
+    int itCount{0};
+    while (itCount++ < 100) {
+        {
+            std::lock_guard<std::mutex> lock(receivedLock);
+            if (received.size() >= expected.size()) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    {
+        std::lock_guard<std::mutex> lock(receivedLock);
+        CHECK(received == expected);
+    }
+    CHECK(cpt->getPendingSendCount() == 0);
+    cpt->close();
+    runner.join();
+    spt->close();
+}
+
+TEST_CASE("sendBeforeConnectFailureTest", "[TcpOps]")
+{
+    asio::io_context context;
+    // nothing is listening on the port
+    auto cpt = TcpConnection::create(context, "localhost", "19887", 1024);
+    std::atomic<int> errorCount{0};
+    cpt->setErrorCall([&errorCount](
+                          const TcpConnection::pointer&,
+                          const std::error_code& error) {
+        CHECK(error);
+        ++errorCount;
+        return false;
+    });
+    cpt->setConnectQueueLimit(100);
+    std::error_code sendError;
+    cpt->asyncSend(
+        std::string(50, 'a'),
+        [&sendError](const std::error_code& error, size_t bytes) {
+            sendError = error;
+            CHECK(bytes == 0);
+        });
+    // over the limit
+    CHECK(cpt->send(std::string(60, 'b')) == 0);
+    CHECK(cpt->getPendingSendCount() == 1);
+
+    context.run();
+    CHECK_FALSE(cpt->isConnected());
+    CHECK(errorCount.load() == 1);
+    CHECK(sendError);
+    CHECK(cpt->getPendingSendCount() == 0);
+    CHECK(cpt->getStatistics().errors == 2);
+}
+
+TEST_CASE("serverContextPoolTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto pool = AsioContextPool::create("serverPool", 2, false);
+    pool->start();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setContextPool(pool);
+    std::mutex contextLock;
+    std::set<std::thread::id> threads;
+    std::atomic<size_t> received{0};
+    spt->setDataCall([&](const TcpConnection::pointer&,
+                         const char* /*data*/,
+                         size_t datasize) {
+        {
+            std::lock_guard<std::mutex> lock(contextLock);
+            threads.insert(std::this_thread::get_id());
+        }
+        received += datasize;
+        return datasize;
+    });
+    spt->start();
+
+    std::vector<TcpConnection::pointer> clients;
+    for (int ii = 0; ii < 4; ++ii) {
+        auto cpt = establishConnection(
+            io_context_server->getBaseContext(),
+            std::string("localhost"),
+            "19888",
+            std::chrono::milliseconds(1000));
+        REQUIRE(cpt);
+        REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+        cpt->send(std::string("pooled"));
+        clients.push_back(std::move(cpt));
+    }
+    int itCount{0};
+    while (received.load() < 4 * 6 && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(received.load() == 4 * 6);
+    {
+        std::lock_guard<std::mutex> lock(contextLock);
+        // each pool context has its own thread
+        CHECK(threads.size() == 2);
+    }
+    spt->close();
+    for (auto& cpt : clients) {
+        cpt->close();
+    }
+}
+
+TEST_CASE("shardedAcceptorTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto pool = AsioContextPool::create("shardPool", 2, false);
+    pool->start();
+    std::mutex threadLock;
+    std::set<std::thread::id> poolThreads;
+    for (size_t ii = 0; ii < pool->size(); ++ii) {
+        std::promise<std::thread::id> threadId;
+        auto result = threadId.get_future();
+        asio::post(pool->getContext(ii), [&threadId]() {
+            threadId.set_value(std::this_thread::get_id());
+        });
+        poolThreads.insert(result.get());
+    }
+    REQUIRE(poolThreads.size() == 2);
+
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setContextPool(pool, TcpServer::PoolMode::SHARDED_ACCEPTORS);
+    REQUIRE(spt->isReady());
+    std::set<std::thread::id> threads;
+    std::atomic<size_t> received{0};
+    spt->setDataCall([&](const TcpConnection::pointer&,
+                         const char* /*data*/,
+                         size_t datasize) {
+        {
+            std::lock_guard<std::mutex> lock(threadLock);
+            threads.insert(std::this_thread::get_id());
+        }
+        received += datasize;
+        return datasize;
+    });
+    REQUIRE(spt->start());
+
+    constexpr size_t clientCount{32};
+    std::vector<TcpConnection::pointer> clients;
+    for (size_t ii = 0; ii < clientCount; ++ii) {
+        auto cpt = establishConnection(
+            io_context_server->getBaseContext(),
+            std::string("localhost"),
+            "19888",
+            std::chrono::milliseconds(1000));
+        REQUIRE(cpt);
+        REQUIRE(cpt->waitUntilConnected(std::chrono::milliseconds(1000)));
+        cpt->send(std::string("shard"));
+        clients.push_back(std::move(cpt));
+    }
+    int itCount{0};
+    while (received.load() < clientCount * 5 && itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(received.load() == clientCount * 5);
+    {
+        std::lock_guard<std::mutex> lock(threadLock);
+        for (const auto& id : threads) {
+            CHECK(poolThreads.count(id) == 1);
+        }
+#ifdef __linux__
+        CHECK(spt->getAcceptorCount() >= 2);
+        // the kernel hashes connections over the listeners so with this many
+        // both are practically certain to be used
+        CHECK(threads.size() == 2);
+#endif
+    }
+    spt->close();
+    for (auto& cpt : clients) {
+        cpt->close();
+    }
+}
+
+TEST_CASE("pendingAcceptsTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true, 1024);
+    REQUIRE(spt->isReady());
+    spt->setListenBacklog(128);
+    spt->setPendingAccepts(8);
+    spt->setDataCall([](const TcpConnection::pointer&,
+                        const char* /*data*/,
+                        size_t datasize) { return datasize; });
+    REQUIRE(spt->start());
+    // starting again only tops up the pending accepts
+    CHECK(spt->start());
+
+    constexpr size_t threadCount{4};
+    constexpr size_t clientsPerThread{16};
+    std::mutex clientLock;
+    std::vector<TcpConnection::pointer> clients;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> connectors;
+    for (size_t ii = 0; ii < threadCount; ++ii) {
+        connectors.emplace_back([&]() {
+            for (size_t jj = 0; jj < clientsPerThread; ++jj) {
+                auto cpt = establishConnection(
+                    io_context_server->getBaseContext(),
+                    std::string("localhost"),
+                    "19888",
+                    std::chrono::milliseconds(2000));
+                if (!cpt ||
+                    !cpt->waitUntilConnected(std::chrono::milliseconds(2000))) {
+                    ++failures;
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(clientLock);
+                clients.push_back(std::move(cpt));
+            }
+        });
+    }
+    for (auto& connector : connectors) {
+        connector.join();
+    }
+    CHECK(failures.load() == 0);
+    int itCount{0};
+    while (spt->getConnectionStatistics().size() < clients.size() &&
+           itCount++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(
+        spt->getConnectionStatistics().size() ==
+        threadCount * clientsPerThread);
+    for (auto& cpt : clients) {
+        cpt->close();
+    }
+    spt->close();
+}
+
+TEST_CASE("establishConnectionAsyncTest", "[TcpOps]")
+{
+    auto ioctx =
+        gmlc::networking::AsioContextManager::getContextPointer("establish");
+    auto loop = ioctx->startContextLoop();
+    ConnectionRetryPolicy policy;
+    policy.initialDelay = std::chrono::milliseconds(20);
+    policy.maxDelay = std::chrono::milliseconds(100);
+
+    // the server starts well after the first attempts fail
+    constexpr auto serverDelay = std::chrono::milliseconds(300);
+    const auto start = std::chrono::steady_clock::now();
+    auto pending = establishConnectionAsync(
+        ioctx->getBaseContext(),
+        "localhost",
+        "19888",
+        std::chrono::milliseconds(5000),
+        policy);
+    std::this_thread::sleep_for(serverDelay);
+    auto spt =
+        TcpServer::create(ioctx->getBaseContext(), "localhost", 19888, true);
+    REQUIRE(spt->isReady());
+    spt->setDataCall(
+        [](const TcpConnection::pointer&, const char*, size_t datasize) {
+            return datasize;
+        });
+    REQUIRE(spt->start());
+
+    REQUIRE(
+        pending.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    auto cpt = pending.get();
+    const auto timeToConnect = std::chrono::duration_cast<
+        std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    REQUIRE(cpt);
+    CHECK(cpt->isConnected());
+    INFO("connected after " << timeToConnect.count() << "ms");
+    CHECK(timeToConnect >= serverDelay);
+    // a retry follows within the maximum delay of the server starting
+    CHECK(timeToConnect < serverDelay + std::chrono::milliseconds(1000));
+    cpt->close();
+    spt->close();
+}
+
+TEST_CASE("establishConnectionAsyncTimeoutTest", "[TcpOps]")
+{
+    asio::io_context context;
+    ConnectionRetryPolicy policy;
+    policy.initialDelay = std::chrono::milliseconds(10);
+    policy.maxDelay = std::chrono::milliseconds(40);
+    int calls{0};
+    std::error_code result;
+    TcpConnection::pointer connection;
+    const auto start = std::chrono::steady_clock::now();
+    // nothing is listening on the port
+    establishConnectionAsync(
+        SocketFactory(),
+        context,
+        "localhost",
+        "19887",
+        std::chrono::milliseconds(300),
+        [&](const TcpConnection::pointer& conn, const std::error_code& error) {
+            ++calls;
+            connection = conn;
+            result = error;
+        },
+        policy);
+    context.run();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(calls == 1);
+    CHECK_FALSE(connection);
+    CHECK(result == asio::error::connection_refused);
+    CHECK(elapsed < std::chrono::seconds(2));
+}
+
+TEST_CASE("establishConnectionsTest", "[TcpOps]")
+{
+    auto io_context_server =
+        gmlc::networking::AsioContextManager::getContextPointer(
+            "io_context_server");
+    auto server_context_loop = io_context_server->startContextLoop();
+    auto spt = TcpServer::create(
+        io_context_server->getBaseContext(), "localhost", 19888, true);
+    REQUIRE(spt->isReady());
+    spt->setDataCall(
+        [](const TcpConnection::pointer&, const char*, size_t datasize) {
+            return datasize;
+        });
+    REQUIRE(spt->start());
+    auto pool = AsioContextPool::create("establishPool", 2, false);
+    pool->start();
+
+    ConnectionRetryPolicy policy;
+    policy.initialDelay = std::chrono::milliseconds(20);
+    policy.maxDelay = std::chrono::milliseconds(100);
+    constexpr size_t peers{40};
+    std::vector<std::string> addresses(peers, "localhost:19888");
+    // nothing is listening on the last one
+    addresses.emplace_back("localhost:19887");
+    constexpr auto timeOut = std::chrono::milliseconds(500);
+    const auto start = std::chrono::steady_clock::now();
+    auto results =
+        establishConnections(SocketFactory(), *pool, addresses, timeOut, policy);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(results.size() == addresses.size());
+    size_t connected{0};
+    for (size_t ii = 0; ii < peers; ++ii) {
+        CHECK(results[ii].address == addresses[ii]);
+        if (results[ii].connection && results[ii].connection->isConnected()) {
+            ++connected;
+        }
+    }
+    CHECK(connected == peers);
+    CHECK_FALSE(results.back().connection);
+    CHECK(results.back().error == asio::error::connection_refused);
+    CHECK(results.back().elapsed <= timeOut);
+    // the group takes as long as the failing peer, not the sum of the peers
+    CHECK(elapsed < timeOut + std::chrono::milliseconds(1000));
+
+    bool empty{false};
+    establishConnectionsAsync(
+        SocketFactory(),
+        io_context_server->getBaseContext(),
+        {},
+        timeOut,
+        [&empty](std::vector<EstablishResult> none) { empty = none.empty(); });
+    CHECK(empty);
+
+    for (auto& result : results) {
+        if (result.connection) {
+            result.connection->close();
+        }
+    }
+    spt->close();
+}